@@ -0,0 +1,225 @@
+/*
+ * bench.hpp
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+// Minimal benchmark harness shared by the bench/ executables. Results are emitted as either CSV or
+// a JSON array on stdout so runs can be diffed between releases.
+//
+// Common flags:
+//   --format=csv|json   output format (default csv)
+//   --min-size=N        smallest list size in the sweep (default 10)
+//   --max-size=N        largest list size in the sweep (default 10000000)
+//   --reps=N            timed repetitions per case, the minimum and median are reported (default 5)
+//   --filter=STR        only run cases whose name contains STR
+namespace bench {
+
+struct options {
+  bool json = false;
+  std::size_t min_size = 10;
+  std::size_t max_size = 10'000'000;
+  std::size_t reps = 5;
+  std::string filter;
+  // roughly how many elements each timed repetition should touch. Small sizes are run across
+  // several independent instances so clock overhead doesn't dominate.
+  std::size_t work_per_rep = 1 << 20;
+};
+
+inline options parse_options(int argc, char** argv, options opts = {}) {
+  auto usage = [&] {
+    std::fprintf(stderr,
+                 "usage: %s [--format=csv|json] [--min-size=N] [--max-size=N] [--reps=N] "
+                 "[--filter=STR]\n",
+                 argv[0]);
+    std::exit(1);
+  };
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    auto value_of = [&](const char* flag) -> const char* {
+      std::size_t len = std::strlen(flag);
+      if (std::strncmp(arg, flag, len) == 0 && arg[len] == '=') {
+        return arg + len + 1;
+      }
+      return nullptr;
+    };
+    const char* format = value_of("--format");
+    const char* min_size = value_of("--min-size");
+    const char* max_size = value_of("--max-size");
+    const char* reps = value_of("--reps");
+    const char* filter = value_of("--filter");
+    if (format != nullptr) {
+      if (std::strcmp(format, "json") == 0) {
+        opts.json = true;
+      } else if (std::strcmp(format, "csv") == 0) {
+        opts.json = false;
+      } else {
+        usage();
+      }
+    } else if (min_size != nullptr) {
+      opts.min_size = std::strtoull(min_size, nullptr, 10);
+    } else if (max_size != nullptr) {
+      opts.max_size = std::strtoull(max_size, nullptr, 10);
+    } else if (reps != nullptr) {
+      opts.reps = std::max<std::size_t>(1, std::strtoull(reps, nullptr, 10));
+    } else if (filter != nullptr) {
+      opts.filter = filter;
+    } else {
+      usage();
+    }
+  }
+  return opts;
+}
+
+// sizes 10, 100, ..., clamped to [min_size, max_size].
+inline std::vector<std::size_t> size_sweep(const options& opts) {
+  std::vector<std::size_t> sizes;
+  for (std::size_t n = 10; n <= opts.max_size; n *= 10) {
+    if (n >= opts.min_size) {
+      sizes.push_back(n);
+    }
+  }
+  return sizes;
+}
+
+// number of independent instances to run per repetition for a list of `n` elements.
+inline std::size_t instances_for(const options& opts, std::size_t n) {
+  return std::max<std::size_t>(1, opts.work_per_rep / std::max<std::size_t>(1, n));
+}
+
+template <typename T>
+inline void do_not_optimize(T&& value) {
+#if defined(__GNUC__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile auto sink = value;
+  sink = value;
+#endif
+}
+
+inline void clobber_memory() {
+#if defined(__GNUC__)
+  asm volatile("" : : : "memory");
+#endif
+}
+
+// An access order over `n` objects stored contiguously. `hot` walks them in address order, `cold`
+// visits them in a random permutation so consecutive list nodes land on unrelated cache lines.
+enum class layout { hot, cold };
+
+inline const char* layout_name(layout l) {
+  return l == layout::hot ? "hot" : "cold";
+}
+
+inline std::vector<std::size_t> access_order(std::size_t n, layout l, std::uint64_t seed = 42) {
+  std::vector<std::size_t> order(n);
+  std::iota(order.begin(), order.end(), std::size_t{0});
+  if (l == layout::cold) {
+    std::mt19937_64 rng{seed};
+    std::shuffle(order.begin(), order.end(), rng);
+  }
+  return order;
+}
+
+struct result {
+  std::string benchmark;
+  std::string container;
+  std::string layout;
+  std::size_t size;
+  double ns_per_op_min;
+  double ns_per_op_median;
+  std::size_t reps;
+  // memory footprint per element, 0 if the benchmark doesn't report it.
+  std::size_t bytes_per_element = 0;
+};
+
+class reporter {
+public:
+  explicit reporter(const options& opts) : opts_(opts) {
+    if (opts_.json) {
+      std::printf("[\n");
+    } else {
+      std::printf(
+        "benchmark,container,layout,size,ns_per_op_min,ns_per_op_median,mops_per_sec,reps,"
+        "bytes_per_element\n");
+    }
+  }
+
+  reporter(const reporter&) = delete;
+  reporter& operator=(const reporter&) = delete;
+
+  ~reporter() {
+    if (opts_.json) {
+      std::printf("\n]\n");
+    }
+  }
+
+  void add(const result& r) {
+    std::string bytes = r.bytes_per_element != 0 ? std::to_string(r.bytes_per_element) : "";
+    // throughput at the median, millions of operations per second.
+    double mops = r.ns_per_op_median > 0 ? 1e3 / r.ns_per_op_median : 0;
+    if (opts_.json) {
+      std::printf("%s  {\"benchmark\": \"%s\", \"container\": \"%s\", \"layout\": \"%s\", "
+                  "\"size\": %zu, \"ns_per_op_min\": %.3f, \"ns_per_op_median\": %.3f, "
+                  "\"mops_per_sec\": %.3f, \"reps\": %zu, \"bytes_per_element\": %s}",
+                  first_ ? "" : ",\n", r.benchmark.c_str(), r.container.c_str(), r.layout.c_str(),
+                  r.size, r.ns_per_op_min, r.ns_per_op_median, mops, r.reps,
+                  bytes.empty() ? "null" : bytes.c_str());
+    } else {
+      std::printf("%s,%s,%s,%zu,%.3f,%.3f,%.3f,%zu,%s\n", r.benchmark.c_str(), r.container.c_str(),
+                  r.layout.c_str(), r.size, r.ns_per_op_min, r.ns_per_op_median, mops, r.reps,
+                  bytes.c_str());
+    }
+    first_ = false;
+    std::fflush(stdout);
+  }
+
+  bool wants(const std::string& name) const {
+    return opts_.filter.empty() || name.find(opts_.filter) != std::string::npos;
+  }
+
+  const options& opts() const { return opts_; }
+
+private:
+  const options& opts_;
+  bool first_ = true;
+};
+
+using bench_clock = std::chrono::steady_clock;
+
+// Runs `setup()` untimed then `run()` timed, `reps` times. `ops` is the number of operations a
+// single `run()` performs, used to normalize to ns/op.
+template <typename Setup, typename Run>
+result measure(const options& opts, std::string benchmark, std::string container, layout l,
+               std::size_t size, std::size_t ops, Setup&& setup, Run&& run) {
+  std::vector<double> samples;
+  samples.reserve(opts.reps);
+  for (std::size_t rep = 0; rep < opts.reps; ++rep) {
+    setup();
+    clobber_memory();
+    auto start = bench_clock::now();
+    run();
+    clobber_memory();
+    auto stop = bench_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    samples.push_back(ns / static_cast<double>(std::max<std::size_t>(1, ops)));
+  }
+  std::sort(samples.begin(), samples.end());
+  return result{std::move(benchmark),  std::move(container), layout_name(l), size, samples.front(),
+                samples[samples.size() / 2], samples.size()};
+}
+
+} // namespace bench
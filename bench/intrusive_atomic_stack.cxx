@@ -0,0 +1,104 @@
+/*
+ * intrusive_atomic_stack.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+// Free list throughput of pep::intrusive_atomic_stack, with and without elimination backoff, against
+// a pep::intrusive_list behind a std::mutex. Every thread repeatedly pops an element and pushes it
+// back. The `size` column is the number of threads, ns/op is wall time over the total number of
+// push and pop calls across all threads and mops_per_sec is the aggregate throughput.
+
+#include "../intrusive_atomic_stack.hpp"
+#include "../intrusive_list.hpp"
+#include "bench.hpp"
+#include <mutex>
+#include <thread>
+
+namespace {
+
+struct item {
+  std::uint64_t value;
+  pep::intrusive_stack_node stack_node;
+  pep::intrusive_node list_node;
+};
+
+template <typename... Options>
+struct atomic_impl {
+  pep::intrusive_atomic_stack<item, &item::stack_node, Options...> stack;
+
+  void push(item& v) { stack.push(v); }
+  item* pop() { return stack.pop(); }
+};
+
+struct mutex_impl {
+  std::mutex lock;
+  pep::intrusive_list<item, &item::list_node> list;
+
+  void push(item& v) {
+    std::lock_guard<std::mutex> guard{lock};
+    list.push_back(v);
+  }
+  item* pop() {
+    std::lock_guard<std::mutex> guard{lock};
+    if (list.empty()) {
+      return nullptr;
+    }
+    item* v = &list.back();
+    list.pop_back();
+    return v;
+  }
+};
+
+constexpr std::size_t pool_size = 1024;
+
+template <typename Impl>
+void run_suite(bench::reporter& rep, const char* name, std::size_t threads) {
+  if (!rep.wants("push_pop")) {
+    return;
+  }
+  std::vector<item> pool(pool_size);
+  Impl impl;
+  for (item& v : pool) {
+    impl.push(v);
+  }
+  std::size_t per_thread = rep.opts().work_per_rep / threads;
+  rep.add(bench::measure(rep.opts(), "push_pop", name, bench::layout::hot, threads,
+                         2 * per_thread * threads, [] {}, [&] {
+                           std::atomic<std::size_t> ready{0};
+                           std::vector<std::thread> workers;
+                           for (std::size_t t = 0; t != threads; ++t) {
+                             workers.emplace_back([&] {
+                               ready.fetch_add(1);
+                               while (ready.load() != threads) {
+                               }
+                               for (std::size_t i = 0; i != per_thread; ++i) {
+                                 if (item* v = impl.pop()) {
+                                   ++v->value;
+                                   impl.push(*v);
+                                 }
+                               }
+                             });
+                           }
+                           for (std::thread& w : workers) {
+                             w.join();
+                           }
+                         }));
+  while (impl.pop() != nullptr) {
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  bench::options opts = bench::parse_options(argc, argv);
+  bench::reporter rep{opts};
+  std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+  for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+    run_suite<atomic_impl<>>(rep, "intrusive_atomic_stack", threads);
+    run_suite<atomic_impl<pep::elimination_backoff<8>>>(rep, "intrusive_atomic_stack+elimination",
+                                                        threads);
+    run_suite<mutex_impl>(rep, "mutex+intrusive_list", threads);
+  }
+}
@@ -0,0 +1,103 @@
+/*
+ * intrusive_generation_list.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+// pep::intrusive_generation_list against intrusive_list in auto_unlink and normal link mode for
+// the per-frame pattern: a list over long-lived elements that is refilled and reset over and over.
+//
+//   clear      clear a full list.
+//   frame      link every element, then clear the list.
+//   push_back  link every element into an empty list that was cleared while full.
+//
+// normal mode also clears in O(1), but its elements can't tell whether they are linked and must
+// not be destroyed while they are; generation list elements keep both guarantees. `cold` links the
+// elements in a shuffled order.
+
+#include "../intrusive_generation_list.hpp"
+#include "bench.hpp"
+#include <memory>
+
+namespace {
+
+template <pep::link_mode Mode>
+struct item {
+  std::uint64_t value = 0;
+  pep::basic_intrusive_node<Mode> node;
+};
+
+struct gen_item {
+  std::uint64_t value = 0;
+  pep::intrusive_generation_node node;
+};
+
+template <pep::link_mode Mode>
+struct list_impl {
+  using value_type = item<Mode>;
+  static constexpr const char* name =
+    Mode == pep::link_mode::normal ? "intrusive_list<normal>" : "intrusive_list<auto_unlink>";
+  pep::intrusive_list<value_type, &value_type::node> list;
+};
+
+struct generation_impl {
+  using value_type = gen_item;
+  static constexpr const char* name = "intrusive_generation_list";
+  pep::intrusive_generation_list<gen_item, &gen_item::node> list;
+};
+
+template <typename Impl>
+void run_suite(bench::reporter& rep, std::size_t n, bench::layout l) {
+  using value_type = typename Impl::value_type;
+  std::vector<std::size_t> order = bench::access_order(n, l);
+  Impl impl;
+  std::unique_ptr<value_type[]> items{new value_type[n]};
+  auto link_all = [&] {
+    for (std::size_t idx : order) {
+      impl.list.push_back(items[idx]);
+    }
+  };
+  auto fill = [&] {
+    impl.list.clear();
+    link_all();
+  };
+
+  if (rep.wants("clear")) {
+    rep.add(bench::measure(rep.opts(), "clear", Impl::name, l, n, n, fill, [&] {
+      impl.list.clear();
+      bench::clobber_memory();
+    }));
+  }
+  if (rep.wants("frame")) {
+    rep.add(bench::measure(rep.opts(), "frame", Impl::name, l, n, n, [&] { impl.list.clear(); },
+                           [&] {
+                             link_all();
+                             impl.list.clear();
+                             bench::clobber_memory();
+                           }));
+  }
+  if (rep.wants("push_back")) {
+    rep.add(bench::measure(rep.opts(), "push_back", Impl::name, l, n, n, [&] {
+      fill();
+      impl.list.clear();
+    }, link_all));
+  }
+  impl.list.clear();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  bench::options defaults;
+  defaults.max_size = 1'000'000;
+  bench::options opts = bench::parse_options(argc, argv, defaults);
+  bench::reporter rep{opts};
+  for (std::size_t n : bench::size_sweep(opts)) {
+    for (bench::layout l : {bench::layout::hot, bench::layout::cold}) {
+      run_suite<list_impl<pep::link_mode::auto_unlink>>(rep, n, l);
+      run_suite<list_impl<pep::link_mode::normal>>(rep, n, l);
+      run_suite<generation_impl>(rep, n, l);
+    }
+  }
+}
@@ -0,0 +1,134 @@
+/*
+ * intrusive_hash_table.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+// pep::intrusive_hash_table against std::unordered_map<K, T*> for insert, successful and failed
+// lookups and erase, starting from an empty table each time so growth is included. Keys are random
+// 64-bit integers; `cold` inserts the objects in a shuffled order.
+//
+// insert_max_latency times every insert of a run individually and reports the slowest one, which
+// is where a stop-the-world rehash shows up.
+
+#include "../intrusive_hash_table.hpp"
+#include "bench.hpp"
+#include <memory>
+#include <unordered_map>
+
+namespace {
+
+struct item {
+  std::uint64_t key;
+  std::uint64_t value;
+  pep::intrusive_hash_node node;
+};
+
+struct key_of_item {
+  std::uint64_t operator()(const item& v) const { return v.key; }
+};
+
+struct intrusive_impl {
+  static constexpr const char* name = "intrusive_hash_table";
+  pep::intrusive_hash_table<item, &item::node, key_of_item> table;
+
+  void insert(item& v) { table.insert(v); }
+  item* find(std::uint64_t key) { return table.find(key); }
+  void erase(item& v) { table.erase(v); }
+  void clear() { table.clear(); }
+};
+
+struct std_impl {
+  static constexpr const char* name = "std::unordered_map<K,T*>";
+  std::unordered_map<std::uint64_t, item*> table;
+
+  void insert(item& v) { table.emplace(v.key, &v); }
+  item* find(std::uint64_t key) {
+    auto it = table.find(key);
+    return it != table.end() ? it->second : nullptr;
+  }
+  void erase(item& v) { table.erase(v.key); }
+  // a fresh map, so the next run grows from scratch like the intrusive table does.
+  void clear() { std::unordered_map<std::uint64_t, item*>().swap(table); }
+};
+
+template <typename Impl>
+void run_suite(bench::reporter& rep, std::size_t n, bench::layout l) {
+  std::vector<std::size_t> order = bench::access_order(n, l);
+  std::mt19937_64 rng{n};
+  std::unique_ptr<item[]> objs{new item[n]};
+  std::vector<std::uint64_t> misses(n);
+  for (std::size_t i = 0; i != n; ++i) {
+    objs[i].key = rng();
+    misses[i] = rng();
+  }
+  Impl impl;
+  auto fill = [&] {
+    impl.clear();
+    for (std::size_t idx : order) {
+      impl.insert(objs[idx]);
+    }
+  };
+
+  if (rep.wants("insert")) {
+    rep.add(bench::measure(rep.opts(), "insert", Impl::name, l, n, n, [&] { impl.clear(); }, [&] {
+      for (std::size_t idx : order) {
+        impl.insert(objs[idx]);
+      }
+    }));
+  }
+  if (rep.wants("insert_max_latency")) {
+    std::vector<double> worst;
+    for (std::size_t r = 0; r != rep.opts().reps; ++r) {
+      impl.clear();
+      double max_ns = 0;
+      for (std::size_t idx : order) {
+        auto start = bench::bench_clock::now();
+        impl.insert(objs[idx]);
+        auto stop = bench::bench_clock::now();
+        max_ns = std::max(max_ns, std::chrono::duration<double, std::nano>(stop - start).count());
+      }
+      worst.push_back(max_ns);
+    }
+    std::sort(worst.begin(), worst.end());
+    rep.add(bench::result{"insert_max_latency", Impl::name, bench::layout_name(l), n,
+                          worst.front(), worst[worst.size() / 2], worst.size()});
+  }
+  fill();
+  if (rep.wants("find_hit")) {
+    rep.add(bench::measure(rep.opts(), "find_hit", Impl::name, l, n, n, [] {}, [&] {
+      for (std::size_t idx : order) {
+        bench::do_not_optimize(impl.find(objs[idx].key));
+      }
+    }));
+  }
+  if (rep.wants("find_miss")) {
+    rep.add(bench::measure(rep.opts(), "find_miss", Impl::name, l, n, n, [] {}, [&] {
+      for (std::uint64_t key : misses) {
+        bench::do_not_optimize(impl.find(key));
+      }
+    }));
+  }
+  if (rep.wants("erase")) {
+    rep.add(bench::measure(rep.opts(), "erase", Impl::name, l, n, n, fill, [&] {
+      for (std::size_t idx : order) {
+        impl.erase(objs[idx]);
+      }
+    }));
+  }
+  impl.clear();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  bench::options opts = bench::parse_options(argc, argv);
+  bench::reporter rep{opts};
+  for (std::size_t n : bench::size_sweep(opts)) {
+    for (bench::layout l : {bench::layout::hot, bench::layout::cold}) {
+      run_suite<intrusive_impl>(rep, n, l);
+      run_suite<std_impl>(rep, n, l);
+    }
+  }
+}
@@ -0,0 +1,157 @@
+/*
+ * intrusive_link_mode.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+// Cost of each link_mode on the unlink paths of pep::intrusive_list:
+//
+//   erase      erase every element of a full list by reference.
+//   pop_front  drain a full list from the front.
+//   clear      clear a full list.
+//   destroy    end the elements' lifetimes: auto_unlink elements are simply destroyed and unlink
+//              themselves, safe and normal ones are cleared from the list first.
+//   dispose    end the elements' lifetimes with clear_and_dispose.
+//   forget     forget() a full list, the arena teardown where the elements are never destroyed.
+//
+// Elements live in raw storage so that `destroy` can run their destructors inside the timed
+// region. `cold` links them in a shuffled order.
+
+#include "../intrusive_list.hpp"
+#include "bench.hpp"
+#include <memory>
+#include <new>
+
+namespace {
+
+template <pep::link_mode Mode>
+struct item {
+  std::uint64_t value = 0;
+  pep::basic_intrusive_node<Mode> node;
+};
+
+template <pep::link_mode Mode>
+constexpr const char* mode_name() {
+  switch (Mode) {
+  case pep::link_mode::normal:
+    return "intrusive_list<normal>";
+  case pep::link_mode::safe:
+    return "intrusive_list<safe>";
+  case pep::link_mode::auto_unlink:
+    return "intrusive_list<auto_unlink>";
+  }
+  return "";
+}
+
+template <pep::link_mode Mode>
+void run_suite(bench::reporter& rep, std::size_t n, bench::layout l) {
+  using value_type = item<Mode>;
+  using list_type = pep::intrusive_list<value_type, &value_type::node>;
+  const char* name = mode_name<Mode>();
+  std::vector<std::size_t> order = bench::access_order(n, l);
+  std::unique_ptr<typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type[]>
+    storage{new typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type[n]};
+  value_type* items = reinterpret_cast<value_type*>(storage.get());
+  for (std::size_t i = 0; i != n; ++i) {
+    new (&items[i]) value_type{};
+  }
+  list_type list;
+  auto fill = [&] {
+    list.clear();
+    for (std::size_t idx : order) {
+      list.push_back(items[idx]);
+    }
+  };
+
+  if (rep.wants("erase")) {
+    rep.add(bench::measure(rep.opts(), "erase", name, l, n, n, fill, [&] {
+      for (std::size_t idx : order) {
+        list.erase(items[idx]);
+      }
+    }));
+  }
+  if (rep.wants("pop_front")) {
+    rep.add(bench::measure(rep.opts(), "pop_front", name, l, n, n, fill, [&] {
+      while (!list.empty()) {
+        list.pop_front();
+      }
+    }));
+  }
+  if (rep.wants("clear")) {
+    rep.add(bench::measure(rep.opts(), "clear", name, l, n, n, fill, [&] { list.clear(); }));
+  }
+  if (rep.wants("destroy")) {
+    auto relink = [&] {
+      list.clear();
+      for (std::size_t i = 0; i != n; ++i) {
+        new (&items[i]) value_type{};
+      }
+      for (std::size_t idx : order) {
+        list.push_back(items[idx]);
+      }
+    };
+    rep.add(bench::measure(rep.opts(), "destroy", name, l, n, n, relink, [&] {
+      if (Mode != pep::link_mode::auto_unlink) {
+        list.clear();
+      }
+      for (std::size_t idx : order) {
+        items[idx].~value_type();
+      }
+      bench::clobber_memory();
+    }));
+    // leave every slot holding a live, unlinked element.
+    list.clear();
+    for (std::size_t i = 0; i != n; ++i) {
+      new (&items[i]) value_type{};
+    }
+  }
+  if (rep.wants("dispose")) {
+    auto relink = [&] {
+      list.clear();
+      for (std::size_t i = 0; i != n; ++i) {
+        new (&items[i]) value_type{};
+      }
+      for (std::size_t idx : order) {
+        list.push_back(items[idx]);
+      }
+    };
+    rep.add(bench::measure(rep.opts(), "dispose", name, l, n, n, relink, [&] {
+      // the disposer has to be seen to do something, or the whole pass is dead code after the
+      // destructors.
+      list.clear_and_dispose([](value_type& v) {
+        bench::do_not_optimize(&v);
+        v.~value_type();
+      });
+      bench::clobber_memory();
+    }));
+    for (std::size_t i = 0; i != n; ++i) {
+      new (&items[i]) value_type{};
+    }
+  }
+  if (rep.wants("forget")) {
+    rep.add(bench::measure(rep.opts(), "forget", name, l, n, n, fill, [&] { list.forget(); }));
+    // the forgotten elements still look linked, start them over.
+    for (std::size_t i = 0; i != n; ++i) {
+      new (&items[i]) value_type{};
+    }
+  }
+  list.clear();
+  for (std::size_t i = 0; i != n; ++i) {
+    items[i].~value_type();
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  bench::options opts = bench::parse_options(argc, argv);
+  bench::reporter rep{opts};
+  for (std::size_t n : bench::size_sweep(opts)) {
+    for (bench::layout l : {bench::layout::hot, bench::layout::cold}) {
+      run_suite<pep::link_mode::auto_unlink>(rep, n, l);
+      run_suite<pep::link_mode::safe>(rep, n, l);
+      run_suite<pep::link_mode::normal>(rep, n, l);
+    }
+  }
+}
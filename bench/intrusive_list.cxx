@@ -0,0 +1,301 @@
+/*
+ * intrusive_list.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+// Hot path microbenchmarks for pep::intrusive_list against std::list<T*> and std::vector<T*>.
+//
+// Every container references objects that already live in a contiguous array, which is the
+// situation an intrusive list is meant for. The `hot` layout links them in address order, the
+// `cold` layout links them in a random permutation of the array.
+//
+// std::list keeps a side table of iterators so it can erase/insert by object in O(1), the same way
+// callers holding std::list iterators would. Operations that are O(n) per element on std::vector
+// (push_front, insert_after, erase by object, pop_front) are only run up to `quadratic_limit`.
+
+#include "../intrusive_list.hpp"
+#include "bench.hpp"
+#include <list>
+#include <memory>
+
+namespace {
+
+struct item {
+  std::uint32_t id;
+  std::uint32_t value;
+  pep::intrusive_node node;
+};
+
+using ilist = pep::intrusive_list<item, &item::node>;
+using counted_ilist = pep::intrusive_list<item, &item::node, pep::constant_time_size<true>>;
+using circular_ilist = pep::intrusive_list<item, &item::node, pep::circular_layout>;
+
+constexpr char ilist_name[] = "intrusive_list";
+constexpr char counted_ilist_name[] = "intrusive_list<constant_time_size>";
+constexpr char circular_ilist_name[] = "intrusive_list<circular_layout>";
+
+constexpr std::size_t quadratic_limit = 10'000;
+
+// remove_if and erase_many drop three elements out of every four ids, so `hot` removes runs of
+// three and `cold` mostly scattered elements.
+bool is_victim(const item& v) {
+  return (v.id & 3) != 0;
+}
+
+template <typename List, const char* Name>
+struct intrusive_impl {
+  static constexpr const char* name = Name;
+  static constexpr bool linear_middle_ops = false;
+
+  List list;
+
+  void reserve(std::size_t) {}
+  void push_back(item& v) { list.push_back(v); }
+  void push_front(item& v) { list.push_front(v); }
+  void insert_after(item& pos, item& v) { list.insert_after(&pos, v); }
+  void erase(item& v) { list.erase(v); }
+  void pop_front() { list.pop_front(); }
+  void pop_back() { list.pop_back(); }
+  void push_back_range(const std::vector<item*>& items) {
+    list.push_back_range(items.begin(), items.end());
+  }
+  void remove_if() { list.remove_if([](const item& v) { return is_victim(v); }); }
+  void erase_many(const std::vector<item*>& victims) {
+    list.erase_many(victims.begin(), victims.end());
+  }
+  void clear() { list.clear(); }
+  std::uint64_t sum() {
+    std::uint64_t total = 0;
+    for (const item& v : list) {
+      total += v.value;
+    }
+    return total;
+  }
+};
+
+struct std_list_impl {
+  static constexpr const char* name = "std::list";
+  static constexpr bool linear_middle_ops = false;
+
+  std::list<item*> list;
+  std::vector<std::list<item*>::iterator> handles;
+
+  void reserve(std::size_t n) { handles.resize(n); }
+  void push_back(item& v) { handles[v.id] = list.insert(list.end(), &v); }
+  void push_front(item& v) { handles[v.id] = list.insert(list.begin(), &v); }
+  void insert_after(item& pos, item& v) {
+    handles[v.id] = list.insert(std::next(handles[pos.id]), &v);
+  }
+  void erase(item& v) { list.erase(handles[v.id]); }
+  void pop_front() { list.pop_front(); }
+  void pop_back() { list.pop_back(); }
+  // every element still needs its handle, so this is push_back in a loop.
+  void push_back_range(const std::vector<item*>& items) {
+    for (item* v : items) {
+      push_back(*v);
+    }
+  }
+  void remove_if() { list.remove_if([](const item* v) { return is_victim(*v); }); }
+  void erase_many(const std::vector<item*>& victims) {
+    for (item* v : victims) {
+      erase(*v);
+    }
+  }
+  void clear() { list.clear(); }
+  std::uint64_t sum() {
+    std::uint64_t total = 0;
+    for (const item* v : list) {
+      total += v->value;
+    }
+    return total;
+  }
+};
+
+struct vector_impl {
+  static constexpr const char* name = "std::vector<T*>";
+  static constexpr bool linear_middle_ops = true;
+
+  std::vector<item*> vec;
+
+  void reserve(std::size_t n) { vec.reserve(n); }
+  void push_back(item& v) { vec.push_back(&v); }
+  void push_front(item& v) { vec.insert(vec.begin(), &v); }
+  void insert_after(item& pos, item& v) {
+    vec.insert(std::find(vec.begin(), vec.end(), &pos) + 1, &v);
+  }
+  void erase(item& v) { vec.erase(std::find(vec.begin(), vec.end(), &v)); }
+  void pop_front() { vec.erase(vec.begin()); }
+  void pop_back() { vec.pop_back(); }
+  void push_back_range(const std::vector<item*>& items) {
+    vec.insert(vec.end(), items.begin(), items.end());
+  }
+  void remove_if() {
+    vec.erase(std::remove_if(vec.begin(), vec.end(), [](const item* v) { return is_victim(*v); }),
+              vec.end());
+  }
+  // finding each victim is O(n), one compaction pass over the victim predicate is the vector's
+  // batch erase.
+  void erase_many(const std::vector<item*>&) { remove_if(); }
+  void clear() { vec.clear(); }
+  std::uint64_t sum() {
+    std::uint64_t total = 0;
+    for (const item* v : vec) {
+      total += v->value;
+    }
+    return total;
+  }
+};
+
+template <typename Impl>
+struct instance {
+  std::unique_ptr<item[]> objs;
+  // the objects in link order, for push_back_range, and the is_victim() ones among them.
+  std::vector<item*> ordered;
+  std::vector<item*> victims;
+  Impl impl;
+
+  instance(std::size_t n, const std::vector<std::size_t>& order) : objs(new item[n]) {
+    for (std::size_t i = 0; i != n; ++i) {
+      objs[i].id = static_cast<std::uint32_t>(i);
+      objs[i].value = static_cast<std::uint32_t>(i);
+    }
+    for (std::size_t idx : order) {
+      ordered.push_back(&objs[idx]);
+      if (is_victim(objs[idx])) {
+        victims.push_back(&objs[idx]);
+      }
+    }
+    impl.reserve(n);
+  }
+};
+
+template <typename Impl>
+class suite {
+public:
+  suite(bench::reporter& rep, std::size_t n, bench::layout l)
+      : rep_(rep), n_(n), layout_(l), order_(bench::access_order(n, l)) {
+    std::size_t count = bench::instances_for(rep.opts(), n);
+    instances_.reserve(count);
+    for (std::size_t i = 0; i != count; ++i) {
+      instances_.push_back(std::make_unique<instance<Impl>>(n, order_));
+    }
+  }
+
+  void run_all() {
+    run("push_back", n_, [&] { reset(); }, [&](instance<Impl>& in) { fill(in); });
+    run("push_back_range", n_, [&] { reset(); },
+        [&](instance<Impl>& in) { in.impl.push_back_range(in.ordered); });
+    run("push_front", n_, [&] { reset(); },
+        [&](instance<Impl>& in) {
+          for (std::size_t idx : order_) {
+            in.impl.push_front(in.objs[idx]);
+          }
+        },
+        Impl::linear_middle_ops);
+    std::size_t half = n_ / 2;
+    run("insert_after", half,
+        [&] {
+          reset();
+          for (auto& in : instances_) {
+            for (std::size_t i = 0; i != half; ++i) {
+              in->impl.push_back(in->objs[order_[i]]);
+            }
+          }
+        },
+        [&](instance<Impl>& in) {
+          for (std::size_t i = 0; i != half; ++i) {
+            in.impl.insert_after(in.objs[order_[i]], in.objs[order_[half + i]]);
+          }
+        },
+        Impl::linear_middle_ops);
+    run("erase", n_, [&] { refill(); },
+        [&](instance<Impl>& in) {
+          for (std::size_t idx : order_) {
+            in.impl.erase(in.objs[idx]);
+          }
+        },
+        Impl::linear_middle_ops);
+    run("pop_front", n_, [&] { refill(); },
+        [&](instance<Impl>& in) {
+          for (std::size_t i = 0; i != n_; ++i) {
+            in.impl.pop_front();
+          }
+        },
+        Impl::linear_middle_ops);
+    run("pop_back", n_, [&] { refill(); },
+        [&](instance<Impl>& in) {
+          for (std::size_t i = 0; i != n_; ++i) {
+            in.impl.pop_back();
+          }
+        });
+    run("remove_if", n_, [&] { refill(); }, [&](instance<Impl>& in) { in.impl.remove_if(); });
+    run("erase_many", n_ - n_ / 4, [&] { refill(); },
+        [&](instance<Impl>& in) { in.impl.erase_many(in.victims); });
+    run("clear", n_, [&] { refill(); }, [&](instance<Impl>& in) { in.impl.clear(); });
+    refill();
+    run("traverse", n_, [] {}, [&](instance<Impl>& in) { bench::do_not_optimize(in.impl.sum()); });
+    reset();
+  }
+
+private:
+  template <typename Setup, typename Op>
+  void run(const char* benchmark, std::size_t ops, Setup&& setup, Op&& op, bool quadratic = false) {
+    if (!rep_.wants(benchmark) || (quadratic && n_ > quadratic_limit)) {
+      return;
+    }
+    rep_.add(bench::measure(
+      rep_.opts(), benchmark, Impl::name, layout_, n_, ops * instances_.size(), setup, [&] {
+        for (auto& in : instances_) {
+          op(*in);
+        }
+      }));
+  }
+
+  void fill(instance<Impl>& in) {
+    for (std::size_t idx : order_) {
+      in.impl.push_back(in.objs[idx]);
+    }
+  }
+
+  void reset() {
+    for (auto& in : instances_) {
+      in->impl.clear();
+    }
+  }
+
+  void refill() {
+    for (auto& in : instances_) {
+      in->impl.clear();
+      fill(*in);
+    }
+  }
+
+  bench::reporter& rep_;
+  std::size_t n_;
+  bench::layout layout_;
+  std::vector<std::size_t> order_;
+  std::vector<std::unique_ptr<instance<Impl>>> instances_;
+};
+
+template <typename Impl>
+void run_suite(bench::reporter& rep, std::size_t n, bench::layout l) {
+  suite<Impl>{rep, n, l}.run_all();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  bench::options opts = bench::parse_options(argc, argv);
+  bench::reporter rep{opts};
+  for (std::size_t n : bench::size_sweep(opts)) {
+    for (bench::layout l : {bench::layout::hot, bench::layout::cold}) {
+      run_suite<intrusive_impl<ilist, ilist_name>>(rep, n, l);
+      run_suite<intrusive_impl<counted_ilist, counted_ilist_name>>(rep, n, l);
+      run_suite<intrusive_impl<circular_ilist, circular_ilist_name>>(rep, n, l);
+      run_suite<std_list_impl>(rep, n, l);
+      run_suite<vector_impl>(rep, n, l);
+    }
+  }
+}
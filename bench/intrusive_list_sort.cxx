@@ -0,0 +1,140 @@
+/*
+ * intrusive_list_sort.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+// intrusive_list::sort and merge against the usual workaround of copying element pointers into a
+// vector, std::stable_sort-ing that and rebuilding the list. Keys are random, `hot`/`cold` controls
+// whether the unsorted list is in address order or shuffled.
+
+#include "../intrusive_list.hpp"
+#include "bench.hpp"
+#include <memory>
+
+namespace {
+
+struct item {
+  std::uint32_t key;
+  pep::intrusive_node node;
+};
+
+using ilist = pep::intrusive_list<item, &item::node>;
+
+bool by_key(const item& a, const item& b) {
+  return a.key < b.key;
+}
+
+void vector_sort(ilist& list, std::vector<item*>& scratch) {
+  scratch.clear();
+  for (item& v : list) {
+    scratch.push_back(&v);
+  }
+  std::stable_sort(scratch.begin(), scratch.end(),
+                   [](const item* a, const item* b) { return a->key < b->key; });
+  list.clear();
+  for (item* v : scratch) {
+    list.push_back(*v);
+  }
+}
+
+void run_suite(bench::reporter& rep, std::size_t n, bench::layout l) {
+  std::vector<std::size_t> order = bench::access_order(n, l);
+  std::size_t count = bench::instances_for(rep.opts(), n);
+  std::mt19937 rng{7};
+  std::vector<std::unique_ptr<item[]>> objs;
+  std::vector<ilist> lists(count);
+  for (std::size_t i = 0; i != count; ++i) {
+    objs.emplace_back(new item[n]);
+    for (std::size_t j = 0; j != n; ++j) {
+      objs.back()[j].key = static_cast<std::uint32_t>(rng());
+    }
+  }
+  auto fill = [&] {
+    for (std::size_t i = 0; i != count; ++i) {
+      lists[i].clear();
+      for (std::size_t idx : order) {
+        lists[i].push_back(objs[i][idx]);
+      }
+    }
+  };
+
+  if (rep.wants("sort")) {
+    rep.add(bench::measure(rep.opts(), "sort", "intrusive_list::sort", l, n, n * count, fill, [&] {
+      for (ilist& list : lists) {
+        list.sort(by_key);
+      }
+    }));
+    std::vector<item*> scratch;
+    scratch.reserve(n);
+    rep.add(bench::measure(rep.opts(), "sort", "vector+stable_sort", l, n, n * count, fill, [&] {
+      for (ilist& list : lists) {
+        vector_sort(list, scratch);
+      }
+    }));
+  }
+
+  if (rep.wants("merge")) {
+    // two sorted halves of each instance, merged back together.
+    std::vector<ilist> others(count);
+    auto split = [&] {
+      fill();
+      for (std::size_t i = 0; i != count; ++i) {
+        others[i].clear();
+        auto mid = lists[i].begin();
+        for (std::size_t j = 0; j != n / 2; ++j) {
+          ++mid;
+        }
+        others[i].splice(others[i].end(), lists[i], mid, lists[i].end());
+        lists[i].sort(by_key);
+        others[i].sort(by_key);
+      }
+    };
+    rep.add(bench::measure(rep.opts(), "merge", "intrusive_list::merge", l, n, n * count, split,
+                           [&] {
+                             for (std::size_t i = 0; i != count; ++i) {
+                               lists[i].merge(others[i], by_key);
+                             }
+                           }));
+    std::vector<item*> scratch(n);
+    rep.add(bench::measure(rep.opts(), "merge", "vector+std::merge", l, n, n * count, split, [&] {
+      for (std::size_t i = 0; i != count; ++i) {
+        std::vector<item*> a, b;
+        for (item& v : lists[i]) {
+          a.push_back(&v);
+        }
+        for (item& v : others[i]) {
+          b.push_back(&v);
+        }
+        std::merge(a.begin(), a.end(), b.begin(), b.end(), scratch.begin(),
+                   [](const item* x, const item* y) { return x->key < y->key; });
+        lists[i].clear();
+        others[i].clear();
+        for (std::size_t j = 0; j != a.size() + b.size(); ++j) {
+          lists[i].push_back(*scratch[j]);
+        }
+      }
+    }));
+    for (ilist& other : others) {
+      other.clear();
+    }
+  }
+  for (ilist& list : lists) {
+    list.clear();
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  bench::options defaults;
+  defaults.max_size = 1'000'000;
+  bench::options opts = bench::parse_options(argc, argv, defaults);
+  bench::reporter rep{opts};
+  for (std::size_t n : bench::size_sweep(opts)) {
+    for (bench::layout l : {bench::layout::hot, bench::layout::cold}) {
+      run_suite(rep, n, l);
+    }
+  }
+}
@@ -0,0 +1,148 @@
+/*
+ * intrusive_object_pool.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+// Allocation churn through pep::intrusive_object_pool against new/delete and malloc/free, for
+// 64 byte objects. The `size` column is the number of threads, ns/op is wall time over the total
+// number of allocations and frees across all threads and mops_per_sec is the aggregate throughput.
+//
+//   churn        every thread allocates a batch of objects, touches them and frees them again.
+//   cross_free   as churn, but half of each batch is freed by the next thread, so blocks keep
+//                migrating between threads.
+
+#include "../intrusive_object_pool.hpp"
+#include "bench.hpp"
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+struct object {
+  std::uint64_t words[8];
+};
+
+struct pool_impl {
+  static constexpr const char* name = "intrusive_object_pool";
+  pep::intrusive_object_pool<object> pool;
+
+  object* allocate() { return pool.allocate(); }
+  void deallocate(object* p) { pool.deallocate(p); }
+};
+
+struct new_impl {
+  static constexpr const char* name = "new/delete";
+
+  object* allocate() { return new object; }
+  void deallocate(object* p) { delete p; }
+};
+
+struct malloc_impl {
+  static constexpr const char* name = "malloc/free";
+
+  object* allocate() { return static_cast<object*>(std::malloc(sizeof(object))); }
+  void deallocate(object* p) { std::free(p); }
+};
+
+constexpr std::size_t batch = 256;
+
+// runs `body(thread_index)` on `threads` threads released together.
+template <typename Body>
+void run_threads(std::size_t threads, Body body) {
+  std::atomic<std::size_t> ready{0};
+  std::vector<std::thread> workers;
+  for (std::size_t t = 0; t != threads; ++t) {
+    workers.emplace_back([&, t] {
+      ready.fetch_add(1);
+      while (ready.load() != threads) {
+      }
+      body(t);
+    });
+  }
+  for (std::thread& w : workers) {
+    w.join();
+  }
+}
+
+template <typename Impl>
+void run_suite(bench::reporter& rep, std::size_t threads) {
+  Impl impl;
+  std::size_t rounds = std::max<std::size_t>(1, rep.opts().work_per_rep / threads / batch);
+  std::size_t ops = 2 * rounds * batch * threads;
+
+  if (rep.wants("churn")) {
+    rep.add(bench::measure(rep.opts(), "churn", Impl::name, bench::layout::hot, threads, ops,
+                           [] {}, [&] {
+                             run_threads(threads, [&](std::size_t) {
+                               object* live[batch];
+                               for (std::size_t r = 0; r != rounds; ++r) {
+                                 for (object*& p : live) {
+                                   p = impl.allocate();
+                                   p->words[0] = r;
+                                 }
+                                 bench::clobber_memory();
+                                 for (object* p : live) {
+                                   impl.deallocate(p);
+                                 }
+                               }
+                             });
+                           }));
+  }
+  if (rep.wants("cross_free")) {
+    std::vector<std::mutex> locks(threads);
+    std::vector<std::vector<object*>> mailbox(threads);
+    rep.add(bench::measure(rep.opts(), "cross_free", Impl::name, bench::layout::hot, threads, ops,
+                           [] {}, [&] {
+                             run_threads(threads, [&](std::size_t t) {
+                               std::size_t next = (t + 1) % threads;
+                               std::vector<object*> live(batch);
+                               std::vector<object*> incoming;
+                               for (std::size_t r = 0; r != rounds; ++r) {
+                                 for (object*& p : live) {
+                                   p = impl.allocate();
+                                   p->words[0] = r;
+                                 }
+                                 {
+                                   std::lock_guard<std::mutex> guard{locks[t]};
+                                   incoming.swap(mailbox[t]);
+                                 }
+                                 for (object* p : incoming) {
+                                   impl.deallocate(p);
+                                 }
+                                 incoming.clear();
+                                 {
+                                   std::lock_guard<std::mutex> guard{locks[next]};
+                                   mailbox[next].insert(mailbox[next].end(),
+                                                        live.begin() + batch / 2, live.end());
+                                 }
+                                 for (std::size_t i = 0; i != batch / 2; ++i) {
+                                   impl.deallocate(live[i]);
+                                 }
+                               }
+                             });
+                             // whatever is left in the mailboxes counts towards this rep.
+                             for (std::vector<object*>& box : mailbox) {
+                               for (object* p : box) {
+                                 impl.deallocate(p);
+                               }
+                               box.clear();
+                             }
+                           }));
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  bench::options opts = bench::parse_options(argc, argv);
+  bench::reporter rep{opts};
+  std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+  for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+    run_suite<pool_impl>(rep, threads);
+    run_suite<new_impl>(rep, threads);
+    run_suite<malloc_impl>(rep, threads);
+  }
+}
@@ -0,0 +1,148 @@
+/*
+ * intrusive_pairing_heap.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+// pep::intrusive_pairing_heap against std::priority_queue with lazy deletion: the queue holds
+// (key, generation, pointer) entries, and decreasing or erasing an element bumps its generation
+// so that its old entries are skipped when they reach the top.
+//
+//   push       push n elements with random keys into an empty heap.
+//   pop        drain a full heap.
+//   decrease   lower every key of a full heap once, then drain it.
+//   erase      erase every other element of a full heap, then drain it.
+// `cold` touches the elements in a shuffled order.
+
+#include "../intrusive_pairing_heap.hpp"
+#include "bench.hpp"
+#include <memory>
+#include <queue>
+
+namespace {
+
+struct item {
+  std::uint64_t key = 0;
+  std::uint64_t generation = 0;
+  pep::intrusive_heap_node node;
+
+  friend bool operator<(const item& a, const item& b) { return a.key < b.key; }
+};
+
+struct pairing_impl {
+  static constexpr const char* name = "intrusive_pairing_heap";
+  pep::intrusive_pairing_heap<item, &item::node> heap;
+
+  void push(item& v) { heap.push(v); }
+  void decrease(item& v, std::uint64_t key) {
+    v.key = key;
+    heap.decrease(v);
+  }
+  void erase(item& v) { heap.erase(v); }
+  std::size_t drain() {
+    std::size_t popped = 0;
+    while (!heap.empty()) {
+      bench::do_not_optimize(heap.top());
+      heap.pop();
+      ++popped;
+    }
+    return popped;
+  }
+};
+
+struct lazy_impl {
+  static constexpr const char* name = "std::priority_queue";
+  struct entry {
+    std::uint64_t key;
+    std::uint64_t generation;
+    item* v;
+    bool operator<(const entry& rhs) const { return key > rhs.key; }
+  };
+  std::priority_queue<entry> heap;
+
+  void push(item& v) { heap.push({v.key, v.generation, &v}); }
+  void decrease(item& v, std::uint64_t key) {
+    v.key = key;
+    heap.push({key, ++v.generation, &v});
+  }
+  void erase(item& v) { ++v.generation; }
+  std::size_t drain() {
+    std::size_t popped = 0;
+    while (!heap.empty()) {
+      entry e = heap.top();
+      heap.pop();
+      if (e.generation == e.v->generation) {
+        bench::do_not_optimize(*e.v);
+        ++popped;
+      }
+    }
+    return popped;
+  }
+};
+
+template <typename Impl>
+void run_suite(bench::reporter& rep, std::size_t n, bench::layout l) {
+  std::vector<std::size_t> order = bench::access_order(n, l);
+  std::mt19937_64 rng{n};
+  std::vector<std::uint64_t> keys(n);
+  std::vector<std::uint64_t> decreases(n);
+  for (std::size_t i = 0; i != n; ++i) {
+    keys[i] = (rng() >> 1) + 1;
+    decreases[i] = rng() % keys[i];
+  }
+  std::unique_ptr<item[]> items{new item[n]};
+  Impl impl;
+  auto fill = [&] {
+    impl.drain();
+    for (std::size_t idx : order) {
+      items[idx].key = keys[idx];
+      impl.push(items[idx]);
+    }
+  };
+
+  if (rep.wants("push")) {
+    rep.add(bench::measure(rep.opts(), "push", Impl::name, l, n, n, [&] { impl.drain(); }, [&] {
+      for (std::size_t idx : order) {
+        items[idx].key = keys[idx];
+        impl.push(items[idx]);
+      }
+    }));
+  }
+  if (rep.wants("pop")) {
+    rep.add(bench::measure(rep.opts(), "pop", Impl::name, l, n, n, fill,
+                           [&] { bench::do_not_optimize(impl.drain()); }));
+  }
+  if (rep.wants("decrease")) {
+    rep.add(bench::measure(rep.opts(), "decrease", Impl::name, l, n, n, fill, [&] {
+      for (std::size_t idx : order) {
+        impl.decrease(items[idx], decreases[idx]);
+      }
+      bench::do_not_optimize(impl.drain());
+    }));
+  }
+  if (rep.wants("erase")) {
+    rep.add(bench::measure(rep.opts(), "erase", Impl::name, l, n, n, fill, [&] {
+      for (std::size_t i = 0; i < n; i += 2) {
+        impl.erase(items[order[i]]);
+      }
+      bench::do_not_optimize(impl.drain());
+    }));
+  }
+  impl.drain();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  bench::options defaults;
+  defaults.max_size = 1'000'000;
+  bench::options opts = bench::parse_options(argc, argv, defaults);
+  bench::reporter rep{opts};
+  for (std::size_t n : bench::size_sweep(opts)) {
+    for (bench::layout l : {bench::layout::hot, bench::layout::cold}) {
+      run_suite<pairing_impl>(rep, n, l);
+      run_suite<lazy_impl>(rep, n, l);
+    }
+  }
+}
@@ -0,0 +1,156 @@
+/*
+ * intrusive_xor_list.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+// Traversal throughput and per-element footprint of pep::intrusive_xor_list against
+// pep::intrusive_list. The interesting sizes are the large ones, where the smaller element lets more
+// of the list fit in cache; pass --max-size=100000000 to go past the default 10M.
+
+#include "../intrusive_list.hpp"
+#include "../intrusive_xor_list.hpp"
+#include "bench.hpp"
+#include <memory>
+
+namespace {
+
+struct list_item {
+  std::uint64_t value;
+  pep::intrusive_node node;
+};
+
+struct xor_item {
+  std::uint64_t value;
+  pep::intrusive_xor_node node;
+};
+
+struct intrusive_impl {
+  static constexpr const char* name = "intrusive_list";
+  using item = list_item;
+
+  pep::intrusive_list<item, &item::node> list;
+
+  void push_back(item& v) { list.push_back(v); }
+  void pop_front() { list.pop_front(); }
+  void clear() { list.clear(); }
+  std::uint64_t sum_forward() const {
+    std::uint64_t total = 0;
+    for (const item& v : list) {
+      total += v.value;
+    }
+    return total;
+  }
+  std::uint64_t sum_backward() const {
+    std::uint64_t total = 0;
+    for (auto it = list.end(), first = list.begin(); it != first;) {
+      --it;
+      total += it->value;
+    }
+    return total;
+  }
+};
+
+struct xor_impl {
+  static constexpr const char* name = "intrusive_xor_list";
+  using item = xor_item;
+
+  pep::intrusive_xor_list<item, &item::node> list;
+
+  void push_back(item& v) { list.push_back(v); }
+  void pop_front() { list.pop_front(); }
+  void clear() { list.clear(); }
+  std::uint64_t sum_forward() const {
+    std::uint64_t total = 0;
+    for (const item& v : list) {
+      total += v.value;
+    }
+    return total;
+  }
+  std::uint64_t sum_backward() const {
+    std::uint64_t total = 0;
+    for (auto it = list.end(), first = list.begin(); it != first;) {
+      --it;
+      total += it->value;
+    }
+    return total;
+  }
+};
+
+template <typename Impl>
+void run_suite(bench::reporter& rep, std::size_t n, bench::layout l) {
+  using item = typename Impl::item;
+  std::vector<std::size_t> order = bench::access_order(n, l);
+  std::size_t count = bench::instances_for(rep.opts(), n);
+  std::vector<std::unique_ptr<item[]>> objs;
+  std::vector<Impl> impls(count);
+  for (std::size_t i = 0; i != count; ++i) {
+    objs.emplace_back(new item[n]);
+    for (std::size_t j = 0; j != n; ++j) {
+      objs.back()[j].value = j;
+    }
+  }
+
+  auto clear = [&] {
+    for (Impl& impl : impls) {
+      impl.clear();
+    }
+  };
+  auto fill = [&] {
+    clear();
+    for (std::size_t i = 0; i != count; ++i) {
+      for (std::size_t idx : order) {
+        impls[i].push_back(objs[i][idx]);
+      }
+    }
+  };
+  auto add = [&](const char* benchmark, auto&& setup, auto&& run) {
+    if (!rep.wants(benchmark)) {
+      return;
+    }
+    bench::result r = bench::measure(rep.opts(), benchmark, Impl::name, l, n, n * count, setup, run);
+    r.bytes_per_element = sizeof(item);
+    rep.add(r);
+  };
+
+  add("push_back", clear, [&] {
+    for (std::size_t i = 0; i != count; ++i) {
+      for (std::size_t idx : order) {
+        impls[i].push_back(objs[i][idx]);
+      }
+    }
+  });
+  add("pop_front", fill, [&] {
+    for (Impl& impl : impls) {
+      for (std::size_t i = 0; i != n; ++i) {
+        impl.pop_front();
+      }
+    }
+  });
+  fill();
+  add("traverse_forward", [] {}, [&] {
+    for (const Impl& impl : impls) {
+      bench::do_not_optimize(impl.sum_forward());
+    }
+  });
+  add("traverse_backward", [] {}, [&] {
+    for (const Impl& impl : impls) {
+      bench::do_not_optimize(impl.sum_backward());
+    }
+  });
+  clear();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  bench::options opts = bench::parse_options(argc, argv);
+  bench::reporter rep{opts};
+  for (std::size_t n : bench::size_sweep(opts)) {
+    for (bench::layout l : {bench::layout::hot, bench::layout::cold}) {
+      run_suite<intrusive_impl>(rep, n, l);
+      run_suite<xor_impl>(rep, n, l);
+    }
+  }
+}
@@ -0,0 +1,347 @@
+/*
+ * intrusive_atomic_stack.hpp Copyright © 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#pragma once
+#include "intrusive_list.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#ifndef STUPIDLY_STD_COMPLIANT
+namespace std {
+struct forward_iterator_tag;
+}
+#endif
+
+namespace pep {
+
+struct intrusive_stack_node;
+template <typename T, intrusive_stack_node T::*node_ptr, typename... Options>
+class intrusive_atomic_stack;
+
+namespace details {
+struct elimination_option_kind;
+} // namespace details
+
+// Gives intrusive_atomic_stack an elimination array of `Slots` cache lines. Under contention a
+// push and a pop that both failed their CAS can meet in a slot and cancel out without touching the
+// top of the stack. 0 disables it.
+template <std::size_t Slots>
+struct elimination_backoff {
+  using option_kind = details::elimination_option_kind;
+  static constexpr std::size_t value = Slots;
+};
+
+// Hook for intrusive_atomic_stack, a single atomic next pointer. Nodes don't know whether they are
+// on a stack, so an element must be popped before it is destroyed.
+struct intrusive_stack_node {
+private:
+  template <typename T, intrusive_stack_node T::*node_ptr, typename... Options>
+  friend class intrusive_atomic_stack;
+  std::atomic<intrusive_stack_node*> next_{nullptr};
+
+public:
+  constexpr intrusive_stack_node() noexcept = default;
+  intrusive_stack_node(const intrusive_stack_node&) = delete;
+  intrusive_stack_node& operator=(const intrusive_stack_node&) = delete;
+
+  // next node of a chain returned by intrusive_atomic_stack::pop_all().
+  intrusive_stack_node* get_next() const { return next_.load(std::memory_order_relaxed); }
+
+  template <typename T, intrusive_stack_node T::*mem_p>
+  const T* owner() const {
+    return details::owner_of<T, intrusive_stack_node, mem_p>(this);
+  }
+
+  template <typename T, intrusive_stack_node T::*mem_p>
+  T* owner() {
+    return const_cast<T*>(const_cast<const intrusive_stack_node*>(this)->owner<T, mem_p>());
+  }
+};
+
+namespace details {
+// The top of an intrusive_atomic_stack: a node pointer and a generation count that are compared and
+// swapped together, so that a pop can't succeed against a node that was popped and pushed back in
+// the meantime (ABA).
+//
+// Where the compiler has an inline double-width CAS (x86-64 with -mcx16, AArch64) the pointer is
+// kept whole next to a 64-bit tag. Elsewhere both share one 64-bit word: the tag takes the bits
+// above the low 48 of a pointer, or above 32 on 32-bit targets. Those bits are only free for
+// untagged user space addresses; AArch64 top-byte tags (TBI, MTE) and 5-level paging addresses use
+// them, so pushing a node whose address doesn't fit aborts rather than corrupting the stack.
+#if defined(__SIZEOF_INT128__) && defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+class tagged_top {
+public:
+  struct value {
+    intrusive_stack_node* ptr;
+    std::uint64_t tag;
+  };
+
+  // the halves may come from different updates; a CAS against a torn value simply fails.
+  value load(std::memory_order order) const {
+    std::uint64_t tag = __atomic_load_n(&words_[1], __ATOMIC_RELAXED);
+    std::uint64_t ptr = __atomic_load_n(&words_[0], order == std::memory_order_relaxed
+                                                      ? __ATOMIC_RELAXED
+                                                      : __ATOMIC_ACQUIRE);
+    return {reinterpret_cast<intrusive_stack_node*>(static_cast<std::uintptr_t>(ptr)), tag};
+  }
+
+  // a full barrier whatever the orders asked for; updates `expected` on failure.
+  bool compare_exchange_weak(value& expected, value desired, std::memory_order,
+                             std::memory_order) {
+    dword old_bits = pack(expected);
+    dword seen = __sync_val_compare_and_swap(reinterpret_cast<dword*>(words_), old_bits,
+                                             pack(desired));
+    if (seen == old_bits) {
+      return true;
+    }
+    expected = {reinterpret_cast<intrusive_stack_node*>(static_cast<std::uintptr_t>(
+                  static_cast<std::uint64_t>(seen))),
+                static_cast<std::uint64_t>(seen >> 64)};
+    return false;
+  }
+
+private:
+  using dword __attribute__((may_alias)) = unsigned __int128;
+
+  static dword pack(value v) {
+    return static_cast<dword>(reinterpret_cast<std::uintptr_t>(v.ptr)) |
+           (static_cast<dword>(v.tag) << 64);
+  }
+
+  // pointer, tag.
+  alignas(16) std::uint64_t words_[2] = {0, 0};
+};
+#else
+class tagged_top {
+public:
+  struct value {
+    intrusive_stack_node* ptr;
+    std::uint64_t tag;
+  };
+
+  value load(std::memory_order order) const { return unpack(word_.load(order)); }
+
+  bool compare_exchange_weak(value& expected, value desired, std::memory_order success,
+                             std::memory_order failure) {
+    std::uint64_t old_bits = pack(expected);
+    bool swapped = word_.compare_exchange_weak(old_bits, pack(desired), success, failure);
+    if (!swapped) {
+      expected = unpack(old_bits);
+    }
+    return swapped;
+  }
+
+private:
+  static constexpr unsigned ptr_bits = sizeof(void*) == 8 ? 48 : 32;
+  static constexpr std::uint64_t ptr_mask = (std::uint64_t{1} << ptr_bits) - 1;
+
+  static std::uint64_t pack(value v) {
+    auto bits = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(v.ptr));
+    if ((bits & ~ptr_mask) != 0) {
+      std::fprintf(stderr, "intrusive_atomic_stack: node address %p uses the tag bits.\n",
+                   static_cast<void*>(v.ptr));
+      std::abort();
+    }
+    return bits | (v.tag << ptr_bits);
+  }
+
+  static value unpack(std::uint64_t w) {
+    return {reinterpret_cast<intrusive_stack_node*>(static_cast<std::uintptr_t>(w & ptr_mask)),
+            w >> ptr_bits};
+  }
+
+  std::atomic<std::uint64_t> word_{0};
+};
+#endif
+
+template <typename... Options>
+struct atomic_stack_options {
+  static constexpr std::size_t elimination_slots =
+    find_option<elimination_option_kind, pep::elimination_backoff<0>, Options...>::type::value;
+};
+
+template <std::size_t Slots>
+class elimination_array {
+public:
+  // offers `n` to a waiting pop for a short while. Returns true if a pop took it.
+  bool try_give(intrusive_stack_node* n) {
+    std::atomic<intrusive_stack_node*>& cell = pick();
+    intrusive_stack_node* expected = nullptr;
+    if (!cell.compare_exchange_strong(expected, n, std::memory_order_release,
+                                      std::memory_order_relaxed)) {
+      return false;
+    }
+    for (int spin = 0; spin != spin_limit; ++spin) {
+      if (cell.load(std::memory_order_relaxed) != n) {
+        return true;
+      }
+    }
+    expected = n;
+    // failing to take it back means a pop got there first.
+    return !cell.compare_exchange_strong(expected, nullptr, std::memory_order_relaxed,
+                                         std::memory_order_relaxed);
+  }
+
+  // takes a node offered by a concurrent push, or returns null.
+  intrusive_stack_node* try_take() {
+    std::atomic<intrusive_stack_node*>& cell = pick();
+    intrusive_stack_node* n = cell.load(std::memory_order_relaxed);
+    if (n == nullptr ||
+        !cell.compare_exchange_strong(n, nullptr, std::memory_order_acquire,
+                                      std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return n;
+  }
+
+private:
+  static constexpr int spin_limit = 128;
+
+  std::atomic<intrusive_stack_node*>& pick() {
+    thread_local std::uint32_t seed = static_cast<std::uint32_t>(
+      reinterpret_cast<std::uintptr_t>(&seed) >> 4);
+    // xorshift32
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return slots_[seed % Slots].ptr;
+  }
+
+  struct alignas(cache_line_size) slot {
+    std::atomic<intrusive_stack_node*> ptr{nullptr};
+  };
+  slot slots_[Slots];
+};
+
+template <>
+class elimination_array<0> {
+public:
+  bool try_give(intrusive_stack_node*) { return false; }
+  intrusive_stack_node* try_take() { return nullptr; }
+};
+} // namespace details
+
+// Lock-free LIFO stack (Treiber) whose link lives in T. The top pointer carries a generation tag
+// that every pop bumps, which defeats ABA; see tagged_top for where the tag is kept.
+//
+// pop() reads the next pointer of a node another thread may have just popped, so elements must not
+// be freed while other threads may still be popping; recycling them (the free list case) is fine.
+template <typename T, intrusive_stack_node T::*node_ptr, typename... Options>
+class intrusive_atomic_stack {
+  using options = details::atomic_stack_options<Options...>;
+  using top_type = details::tagged_top;
+
+public:
+  using value_type = T;
+  using reference = value_type&;
+  using pointer = value_type*;
+
+  // A detached run of elements as returned by pop_all(), most recently pushed first. Owned by the
+  // caller.
+  class chain {
+  public:
+    class iterator {
+    public:
+      using value_type = T;
+      using pointer = value_type*;
+      using reference = value_type&;
+      using difference_type = std::ptrdiff_t;
+      using iterator_category = std::forward_iterator_tag;
+
+      explicit iterator(intrusive_stack_node* ptr) : ptr_(ptr) {}
+
+      reference operator*() const { return *(ptr_->template owner<T, node_ptr>()); }
+      pointer operator->() const { return ptr_->template owner<T, node_ptr>(); }
+
+      iterator& operator++() {
+        ptr_ = ptr_->get_next();
+        return *this;
+      }
+
+      iterator operator++(int) {
+        iterator prev = *this;
+        operator++();
+        return prev;
+      }
+
+      bool operator==(const iterator& rhs) const { return ptr_ == rhs.ptr_; }
+      bool operator!=(const iterator& rhs) const { return !(*this == rhs); }
+
+    private:
+      intrusive_stack_node* ptr_;
+    };
+
+    explicit chain(intrusive_stack_node* head) : head_(head) {}
+
+    [[nodiscard]] bool empty() const { return head_ == nullptr; }
+    iterator begin() const { return iterator{head_}; }
+    iterator end() const { return iterator{nullptr}; }
+
+  private:
+    intrusive_stack_node* head_;
+  };
+
+  intrusive_atomic_stack() noexcept = default;
+
+  intrusive_atomic_stack(const intrusive_atomic_stack&) = delete;
+  intrusive_atomic_stack& operator=(const intrusive_atomic_stack&) = delete;
+
+  void push(reference val) {
+    intrusive_stack_node* n = &(val.*node_ptr);
+    top_type::value top = top_.load(std::memory_order_relaxed);
+    while (true) {
+      n->next_.store(top.ptr, std::memory_order_relaxed);
+      if (top_.compare_exchange_weak(top, {n, top.tag}, std::memory_order_release,
+                                     std::memory_order_relaxed)) {
+        return;
+      }
+      if (elimination_.try_give(n)) {
+        return;
+      }
+      top = top_.load(std::memory_order_relaxed);
+    }
+  }
+
+  // Returns null if the stack is empty.
+  pointer pop() {
+    top_type::value top = top_.load(std::memory_order_acquire);
+    while (true) {
+      intrusive_stack_node* n = top.ptr;
+      if (n == nullptr) {
+        return nullptr;
+      }
+      intrusive_stack_node* next = n->next_.load(std::memory_order_relaxed);
+      if (top_.compare_exchange_weak(top, {next, top.tag + 1}, std::memory_order_acquire,
+                                     std::memory_order_acquire)) {
+        return n->template owner<T, node_ptr>();
+      }
+      if (intrusive_stack_node* given = elimination_.try_take()) {
+        return given->template owner<T, node_ptr>();
+      }
+      top = top_.load(std::memory_order_acquire);
+    }
+  }
+
+  // Detaches every element with a single successful CAS.
+  chain pop_all() {
+    top_type::value top = top_.load(std::memory_order_acquire);
+    while (top.ptr != nullptr &&
+           !top_.compare_exchange_weak(top, {nullptr, top.tag + 1}, std::memory_order_acquire,
+                                       std::memory_order_acquire)) {
+    }
+    return chain{top.ptr};
+  }
+
+  // only a snapshot under concurrent use.
+  [[nodiscard]] bool empty() const {
+    return top_.load(std::memory_order_relaxed).ptr == nullptr;
+  }
+
+private:
+  alignas(details::cache_line_size) top_type top_;
+  details::elimination_array<options::elimination_slots> elimination_;
+};
+} // namespace pep
@@ -0,0 +1,281 @@
+/*
+ * intrusive_generation_list.hpp Copyright © 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#pragma once
+#include "intrusive_list.hpp"
+#include <atomic>
+#include <mutex>
+
+namespace pep {
+
+struct intrusive_generation_node;
+template <typename T, intrusive_generation_node T::*node_ptr>
+class intrusive_generation_list;
+
+namespace details {
+// A list's generation counter. Counters only ever count up and are never freed: a destroyed list
+// bumps its counter one last time and hands it back for reuse, so nodes stamped by it can still
+// read it and will never match it again. Relaxed atomics so a node of a dead list may be checked
+// on one thread while another list that reuses the counter is cleared on another.
+struct generation_counter {
+  std::atomic<std::uint64_t> value{0};
+  generation_counter* next_free = nullptr;
+};
+
+class generation_counters {
+public:
+  static generation_counter* acquire() {
+    std::lock_guard<std::mutex> guard{lock()};
+    generation_counter*& head = free_list();
+    if (head == nullptr) {
+      // reachable from the free list or a live list, never deleted.
+      generation_counter* block = new generation_counter[block_size];
+      for (std::size_t i = 0; i != block_size; ++i) {
+        block[i].next_free = head;
+        head = &block[i];
+      }
+    }
+    generation_counter* c = head;
+    head = c->next_free;
+    return c;
+  }
+
+  static void release(generation_counter* c) {
+    std::lock_guard<std::mutex> guard{lock()};
+    c->next_free = free_list();
+    free_list() = c;
+  }
+
+private:
+  static constexpr std::size_t block_size = 64;
+
+  // never destroyed either, lists with static storage duration may go away after it would have.
+  static std::mutex& lock() {
+    static std::mutex* m = new std::mutex;
+    return *m;
+  }
+  static generation_counter*& free_list() {
+    static generation_counter* head = nullptr;
+    return head;
+  }
+};
+} // namespace details
+
+// Hook for intrusive_generation_list: the two links of an intrusive_node, the generation its list
+// was at when the node was linked, and the counter that list keeps its generation in. Four words.
+// A node is linked only while its stamp matches that counter, so clearing the list unlinks every
+// node at once without touching them. Nodes unlink themselves when destroyed, like intrusive_node.
+// The counter outlives the list, so elements may outlive their list too. A linked node hands its
+// position over when moved from.
+struct intrusive_generation_node : details::ilist_node {
+private:
+  template <typename T, intrusive_generation_node T::*node_ptr>
+  friend class intrusive_generation_list;
+  const details::generation_counter* generation_{nullptr};
+  std::uint64_t stamp_{0};
+
+public:
+  constexpr intrusive_generation_node() noexcept = default;
+
+  intrusive_generation_node(intrusive_generation_node&& other) noexcept { take_links(other); }
+
+  intrusive_generation_node& operator=(intrusive_generation_node&& other) noexcept {
+    if (&other != this) {
+      remove_from_list();
+      take_links(other);
+    }
+    return *this;
+  }
+
+  ~intrusive_generation_node() {
+    if (is_linked()) {
+      unlink();
+    }
+  }
+
+  // false once the node is erased or its list cleared or destroyed; the links themselves are left
+  // stale.
+  bool is_linked() const {
+    return generation_ != nullptr &&
+           generation_->value.load(std::memory_order_relaxed) == stamp_;
+  }
+
+  // Unlinks this node from the list that holds it.
+  void remove_from_list() {
+    if (is_linked()) {
+      unlink();
+    }
+  }
+
+  template <typename T, intrusive_generation_node T::*mem_p>
+  const T* owner() const {
+    return details::owner_of<T, intrusive_generation_node, mem_p>(this);
+  }
+
+  template <typename T, intrusive_generation_node T::*mem_p>
+  T* owner() {
+    return const_cast<T*>(const_cast<const intrusive_generation_node*>(this)->owner<T, mem_p>());
+  }
+
+private:
+  // moves `other`'s position, if it has one, to this unlinked node.
+  void take_links(intrusive_generation_node& other) {
+    if (!other.is_linked()) {
+      return;
+    }
+    set_next(other.get_next());
+    set_prev(other.get_prev());
+    get_prev()->set_next(this);
+    get_next()->set_prev(this);
+    generation_ = other.generation_;
+    stamp_ = other.stamp_;
+    other.generation_ = nullptr;
+  }
+
+  // a current node always has both neighbours, nodes or the list's sentinels.
+  void unlink() {
+    get_prev()->set_next(get_next());
+    get_next()->set_prev(get_prev());
+    generation_ = nullptr;
+  }
+};
+
+// Doubly linked list over intrusive_generation_node hooks whose clear() is O(1) and leaves the
+// elements untouched, whatever the list's length: it bumps the list's generation and resets the
+// sentinels. The elements then read as unlinked and can be linked again or destroyed. Meant for
+// per-frame or per-request lists over elements that outlive many resets, or the list itself.
+//
+// Nodes point at the list's sentinels, so it can't be moved. size() walks the list.
+template <typename T, intrusive_generation_node T::*node_ptr>
+class intrusive_generation_list {
+  using node = details::ilist_node;
+  using gen_node = intrusive_generation_node;
+  using hook = member_hook<T, gen_node, node_ptr>;
+
+public:
+  using value_type = T;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using pointer = value_type*;
+  using const_pointer = const value_type*;
+  using difference_type = std::ptrdiff_t;
+  using size_type = std::size_t;
+
+  using iterator = pep::basic_list_iterator<T, hook>;
+  using const_iterator = pep::basic_list_iterator<T, hook, true>;
+
+  intrusive_generation_list() : generation_(details::generation_counters::acquire()) { reset(); }
+
+  intrusive_generation_list(const intrusive_generation_list&) = delete;
+  intrusive_generation_list& operator=(const intrusive_generation_list&) = delete;
+
+  // the last clear() leaves every node stale for good, then the counter goes back for reuse.
+  ~intrusive_generation_list() {
+    clear();
+    details::generation_counters::release(generation_);
+  }
+
+  [[nodiscard]] bool empty() const { return head_.get_next() == &tail_; }
+
+  // O(n).
+  [[nodiscard]] size_type size() const {
+    size_type count = 0;
+    for (const node* n = head_.get_next(); n != &tail_; n = n->get_next()) {
+      ++count;
+    }
+    return count;
+  }
+
+  // Bumped by every clear().
+  std::uint64_t generation() const { return generation_->value.load(std::memory_order_relaxed); }
+
+  reference front() {
+    assert(!empty());
+    return *hook::owner_of(head_.get_next());
+  }
+
+  const_reference front() const {
+    assert(!empty());
+    return *hook::owner_of(head_.get_next());
+  }
+
+  reference back() {
+    assert(!empty());
+    return *hook::owner_of(tail_.get_prev());
+  }
+
+  const_reference back() const {
+    assert(!empty());
+    return *hook::owner_of(tail_.get_prev());
+  }
+
+  void push_back(reference val) { link_after(*tail_.get_prev(), val.*node_ptr); }
+
+  void push_front(reference val) { link_after(head_, val.*node_ptr); }
+
+  void insert_after(pointer pos, reference val) {
+    assert(pos != nullptr && "can't insert after a null pointer.");
+    assert(is_current(pos->*node_ptr) && "inserting after an element of another list.");
+    link_after(pos->*node_ptr, val.*node_ptr);
+  }
+
+  void pop_front() {
+    assert(!empty());
+    static_cast<gen_node*>(head_.get_next())->unlink();
+  }
+
+  void pop_back() {
+    assert(!empty());
+    static_cast<gen_node*>(tail_.get_prev())->unlink();
+  }
+
+  void erase(reference val) {
+    gen_node& n = val.*node_ptr;
+    assert(is_current(n) && "erasing an element that is not in this list.");
+    n.unlink();
+  }
+
+  void erase(iterator pos) { erase(*pos); }
+
+  // Unlinks every element in O(1) without touching them.
+  void clear() {
+    generation_->value.store(generation() + 1, std::memory_order_relaxed);
+    reset();
+  }
+
+  iterator begin() { return iterator{head_.get_next()}; }
+  const_iterator begin() const { return const_iterator{head_.get_next()}; }
+  const_iterator cbegin() const { return begin(); }
+  iterator end() { return iterator{&tail_}; }
+  const_iterator end() const { return const_iterator{&tail_}; }
+  const_iterator cend() const { return end(); }
+
+private:
+  bool is_current(const gen_node& n) const { return n.generation_ == generation_ && n.is_linked(); }
+
+  void reset() {
+    head_.set_next(&tail_);
+    tail_.set_prev(&head_);
+  }
+
+  // whatever links `n` kept from an earlier generation are simply overwritten.
+  void link_after(node& pos, gen_node& n) {
+    assert(!n.is_linked() && "this node is already part of a list.");
+    node* next = pos.get_next();
+    n.set_prev(&pos);
+    n.set_next(next);
+    pos.set_next(&n);
+    next->set_prev(&n);
+    n.generation_ = generation_;
+    n.stamp_ = generation();
+  }
+
+  node head_{};
+  node tail_{};
+  details::generation_counter* generation_;
+};
+
+} // namespace pep
@@ -0,0 +1,256 @@
+/*
+ * intrusive_hash_table.hpp Copyright © 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#pragma once
+#include "intrusive_list.hpp"
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+namespace pep {
+
+struct intrusive_hash_node;
+template <typename T, intrusive_hash_node T::*node_ptr, typename KeyOf, typename Hash,
+          typename KeyEqual>
+class intrusive_hash_table;
+
+// Hook for intrusive_hash_table: the bucket chain link and the element's cached hash, so lookups
+// can skip most key comparisons and growing never rehashes a key. Nodes don't unlink themselves,
+// an element must be erased before it is destroyed.
+struct intrusive_hash_node {
+private:
+  template <typename T, intrusive_hash_node T::*node_ptr, typename KeyOf, typename Hash,
+            typename KeyEqual>
+  friend class intrusive_hash_table;
+  intrusive_hash_node* next_{nullptr};
+  std::size_t hash_{0};
+
+public:
+  constexpr intrusive_hash_node() noexcept = default;
+  intrusive_hash_node(const intrusive_hash_node&) = delete;
+  intrusive_hash_node& operator=(const intrusive_hash_node&) = delete;
+
+  template <typename T, intrusive_hash_node T::*mem_p>
+  const T* owner() const {
+    return details::owner_of<T, intrusive_hash_node, mem_p>(this);
+  }
+
+  template <typename T, intrusive_hash_node T::*mem_p>
+  T* owner() {
+    return const_cast<T*>(const_cast<const intrusive_hash_node*>(this)->owner<T, mem_p>());
+  }
+};
+
+namespace details {
+// KeyOf applied to a T, decayed.
+template <typename T, typename KeyOf>
+using key_of_t = std::decay_t<decltype(std::declval<const KeyOf&>()(std::declval<const T&>()))>;
+} // namespace details
+
+// Chained hash table whose buckets link through an intrusive_hash_node in T. Keys are unique and
+// are read from the element with `KeyOf`, a functor taking const T&; an identity KeyOf gives a
+// set, one returning a member gives a map. Linking an element never allocates, only the bucket
+// array does when the table grows past a load factor of 1.
+//
+// Growing is incremental: the doubled bucket array is allocated up front, but the old buckets are
+// moved over a few at a time by later inserts and erases, so no single operation relinks the whole
+// table. Lookups meanwhile consult whichever array currently holds the key's bucket.
+//
+// Bucket indices come from Fibonacci hashing of the full hash, so weak hashes such as the
+// identity std::hash<int> still spread across a power-of-two bucket array. With that scheme old
+// bucket i splits exactly into new buckets 2i and 2i + 1.
+template <typename T, intrusive_hash_node T::*node_ptr, typename KeyOf,
+          typename Hash = std::hash<details::key_of_t<T, KeyOf>>,
+          typename KeyEqual = std::equal_to<details::key_of_t<T, KeyOf>>>
+class intrusive_hash_table {
+public:
+  using key_type = details::key_of_t<T, KeyOf>;
+  using value_type = T;
+  using reference = value_type&;
+  using pointer = value_type*;
+  using size_type = std::size_t;
+
+  explicit intrusive_hash_table(KeyOf key_of = KeyOf{}, Hash hash = Hash{},
+                                KeyEqual equal = KeyEqual{})
+      : key_of_(std::move(key_of)), hash_(std::move(hash)), equal_(std::move(equal)) {}
+
+  intrusive_hash_table(const intrusive_hash_table&) = delete;
+  intrusive_hash_table& operator=(const intrusive_hash_table&) = delete;
+
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+  [[nodiscard]] size_type size() const { return size_; }
+  [[nodiscard]] size_type bucket_count() const { return buckets_.size(); }
+  // whether old buckets are still waiting to be moved into the current array.
+  [[nodiscard]] bool rehashing() const { return !old_.empty(); }
+
+  size_type hash(const key_type& key) const { return hash_(key); }
+  const KeyOf& key_of() const { return key_of_; }
+
+  // Links `val` unless an element with an equal key is already present. Returns whether `val` was
+  // linked.
+  bool insert(reference val) { return insert(val, hash(key_of_(val))); }
+
+  // insert() with the hash of val's key precomputed by hash().
+  bool insert(reference val, size_type h) {
+    if (find_node(key_of_(val), h) != nullptr) {
+      return false;
+    }
+    if (size_ + 1 > buckets_.size()) {
+      grow();
+    } else {
+      migrate(migrate_step);
+    }
+    intrusive_hash_node& n = val.*node_ptr;
+    n.hash_ = h;
+    intrusive_hash_node*& bucket = *chain_for(h);
+    n.next_ = bucket;
+    bucket = &n;
+    ++size_;
+    return true;
+  }
+
+  // Returns the element with a key equal to `key`, or null.
+  pointer find(const key_type& key) { return find(key, hash(key)); }
+
+  pointer find(const key_type& key, size_type h) {
+    intrusive_hash_node* n = find_node(key, h);
+    return n != nullptr ? n->template owner<T, node_ptr>() : nullptr;
+  }
+
+  // Unlinks `val`, which must be an element of this table.
+  void erase(reference val) {
+    intrusive_hash_node* n = &(val.*node_ptr);
+    intrusive_hash_node** link = chain_for(n->hash_);
+    while (*link != n) {
+      assert(*link != nullptr && "element isn't in this table.");
+      link = &(*link)->next_;
+    }
+    *link = n->next_;
+    n->next_ = nullptr;
+    --size_;
+    migrate(migrate_step);
+  }
+
+  // Unlinks and returns the element with a key equal to `key`, or returns null.
+  pointer erase(const key_type& key) { return erase(key, hash(key)); }
+
+  pointer erase(const key_type& key, size_type h) {
+    pointer p = find(key, h);
+    if (p != nullptr) {
+      erase(*p);
+    }
+    return p;
+  }
+
+  // Unlinks every element. O(bucket_count()).
+  void clear() {
+    std::fill(buckets_.begin(), buckets_.end(), nullptr);
+    std::vector<intrusive_hash_node*>().swap(old_);
+    migrated_ = 0;
+    size_ = 0;
+  }
+
+private:
+  static constexpr size_type initial_buckets = 16;
+  // old buckets moved per insert or erase while rehashing. Anything above 1 finishes a rehash well
+  // before the next one is due, since that takes as many inserts as there are old buckets.
+  static constexpr size_type migrate_step = 4;
+
+  static size_type bucket_index(size_type h, unsigned shift) {
+    // 2^64 / golden ratio.
+    constexpr std::uint64_t fibonacci = 0x9E3779B97F4A7C15ull;
+    return static_cast<size_type>((static_cast<std::uint64_t>(h) * fibonacci) >> shift);
+  }
+
+  // the bucket currently holding keys that hash to `h`. The buckets must not be empty.
+  intrusive_hash_node* const* chain_for(size_type h) const {
+    if (!old_.empty()) {
+      size_type i = bucket_index(h, old_shift_);
+      if (i >= migrated_) {
+        return &old_[i];
+      }
+    }
+    return &buckets_[bucket_index(h, shift_)];
+  }
+
+  intrusive_hash_node** chain_for(size_type h) {
+    return const_cast<intrusive_hash_node**>(
+      const_cast<const intrusive_hash_table*>(this)->chain_for(h));
+  }
+
+  intrusive_hash_node* find_node(const key_type& key, size_type h) const {
+    if (buckets_.empty()) {
+      return nullptr;
+    }
+    for (intrusive_hash_node* n = *chain_for(h); n != nullptr; n = n->next_) {
+      if (n->hash_ == h && equal_(key_of_(*n->template owner<T, node_ptr>()), key)) {
+        return n;
+      }
+    }
+    return nullptr;
+  }
+
+  // doubles the bucket array and starts moving the old buckets over.
+  void grow() {
+    if (buckets_.empty()) {
+      buckets_.assign(initial_buckets, nullptr);
+      shift_ = shift_for(initial_buckets);
+      return;
+    }
+    // only reachable if erases kept the previous rehash from finishing.
+    migrate(old_.size());
+    size_type count = 2 * buckets_.size();
+    old_.swap(buckets_);
+    old_shift_ = shift_;
+    buckets_.assign(count, nullptr);
+    shift_ = shift_for(count);
+    migrated_ = 0;
+    migrate(migrate_step);
+  }
+
+  // moves up to `count` old buckets into the current array.
+  void migrate(size_type count) {
+    if (old_.empty()) {
+      return;
+    }
+    size_type end = std::min(old_.size(), migrated_ + count);
+    for (; migrated_ != end; ++migrated_) {
+      intrusive_hash_node* n = old_[migrated_];
+      while (n != nullptr) {
+        intrusive_hash_node* next = n->next_;
+        intrusive_hash_node*& bucket = buckets_[bucket_index(n->hash_, shift_)];
+        n->next_ = bucket;
+        bucket = n;
+        n = next;
+      }
+    }
+    if (migrated_ == old_.size()) {
+      std::vector<intrusive_hash_node*>().swap(old_);
+      migrated_ = 0;
+    }
+  }
+
+  // `count` must be a power of two.
+  static unsigned shift_for(size_type count) {
+    unsigned shift = 64;
+    for (; count > 1; count >>= 1) {
+      --shift;
+    }
+    return shift;
+  }
+
+  std::vector<intrusive_hash_node*> buckets_;
+  // buckets [migrated_, old_.size()) of the previous array still hold their elements.
+  std::vector<intrusive_hash_node*> old_;
+  size_type migrated_{0};
+  size_type size_{0};
+  unsigned shift_{64};
+  unsigned old_shift_{64};
+  KeyOf key_of_;
+  Hash hash_;
+  KeyEqual equal_;
+};
+} // namespace pep
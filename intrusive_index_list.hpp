@@ -0,0 +1,307 @@
+/*
+ * intrusive_index_list.hpp Copyright © 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#pragma once
+#include "intrusive_list.hpp"
+
+namespace pep {
+
+struct intrusive_index_node;
+template <typename T, intrusive_index_node T::*node_ptr>
+class intrusive_index_list;
+
+// Doubly-linked hook for objects that live in one contiguous array (the arena). Links are 32-bit
+// indices into the arena instead of pointers, so the hook is 8 bytes and a list stays valid when
+// the arena is moved or reallocated; only the list's base pointer has to be updated, see
+// intrusive_index_list::rebase().
+//
+// A node can't find its arena on its own, so it does not unlink itself on destruction. Moving a
+// node carries its links over unchanged, which is what reallocating the arena needs, but it means
+// an element must not be moved to a different index while linked.
+struct intrusive_index_node {
+  using index_type = std::uint32_t;
+
+  // `next_`/`prev_` of an unlinked node.
+  static constexpr index_type unlinked = 0xFFFFFFFFu;
+  // `next_` of the last node and `prev_` of the first node.
+  static constexpr index_type end = 0xFFFFFFFEu;
+  // largest usable arena.
+  static constexpr index_type max_index = end - 1;
+
+private:
+  template <typename T, intrusive_index_node T::*node_ptr>
+  friend class intrusive_index_list;
+
+  index_type next_{unlinked};
+  index_type prev_{unlinked};
+
+public:
+  constexpr intrusive_index_node() noexcept = default;
+  constexpr intrusive_index_node(const intrusive_index_node& other) = delete;
+  constexpr intrusive_index_node(intrusive_index_node&& other) noexcept
+      : next_(other.next_), prev_(other.prev_) {
+    other.next_ = unlinked;
+    other.prev_ = unlinked;
+  }
+
+  constexpr intrusive_index_node& operator=(const intrusive_index_node&) = delete;
+  constexpr intrusive_index_node& operator=(intrusive_index_node&& other) noexcept {
+    if (&other == this) {
+      return *this;
+    }
+    next_ = other.next_;
+    prev_ = other.prev_;
+    other.next_ = unlinked;
+    other.prev_ = unlinked;
+    return *this;
+  }
+
+  constexpr index_type get_next() const { return next_; }
+  constexpr index_type get_prev() const { return prev_; }
+
+  constexpr bool is_linked() const { return next_ != unlinked; }
+};
+
+template <typename List, bool isConst = false>
+class index_list_iterator {
+  using list_type = std::conditional_t<isConst, const List, List>;
+  using index_type = intrusive_index_node::index_type;
+
+public:
+  using value_type = std::conditional_t<isConst, const typename List::value_type,
+                                        typename List::value_type>;
+  using pointer = value_type*;
+  using reference = value_type&;
+  using difference_type = std::ptrdiff_t;
+  using iterator_category = std::bidirectional_iterator_tag;
+
+  index_list_iterator(list_type* list, index_type idx) : list_(list), idx_(idx) {}
+
+  // iterator -> const_iterator.
+  template <bool wasConst, typename = std::enable_if_t<isConst && !wasConst>>
+  index_list_iterator(const index_list_iterator<List, wasConst>& other)
+      : list_(other.list_), idx_(other.idx_) {}
+
+  reference operator*() const {
+    assert(idx_ != intrusive_index_node::end && "dereferenced end().");
+    return list_->at(idx_);
+  }
+
+  pointer operator->() const { return &operator*(); }
+
+  index_list_iterator& operator++() {
+    idx_ = list_->node_at(idx_).get_next();
+    return *this;
+  }
+
+  index_list_iterator operator++(int) {
+    index_list_iterator prev = *this;
+    operator++();
+    return prev;
+  }
+
+  index_list_iterator& operator--() {
+    idx_ = idx_ == intrusive_index_node::end ? list_->tail_ : list_->node_at(idx_).get_prev();
+    return *this;
+  }
+
+  index_list_iterator operator--(int) {
+    index_list_iterator prev = *this;
+    operator--();
+    return prev;
+  }
+
+  index_type index() const { return idx_; }
+
+  constexpr bool operator==(const index_list_iterator& rhs) const { return idx_ == rhs.idx_; }
+  constexpr bool operator!=(const index_list_iterator& rhs) const { return !(*this == rhs); }
+
+private:
+  template <typename, bool>
+  friend class index_list_iterator;
+
+  list_type* list_;
+  index_type idx_;
+};
+
+// Doubly-linked list over an arena of T. The header is the arena base pointer plus the first and
+// last index.
+template <typename T, intrusive_index_node T::*node_ptr>
+class intrusive_index_list {
+public:
+  using index_type = intrusive_index_node::index_type;
+
+  using value_type = T;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using pointer = value_type*;
+  using const_pointer = const value_type*;
+  using difference_type = std::ptrdiff_t;
+  using size_type = std::size_t;
+
+  using iterator = pep::index_list_iterator<intrusive_index_list>;
+  using const_iterator = pep::index_list_iterator<intrusive_index_list, true>;
+
+  explicit intrusive_index_list(pointer arena) noexcept : base_(arena) {}
+
+  intrusive_index_list(const intrusive_index_list&) = delete;
+  intrusive_index_list& operator=(const intrusive_index_list&) = delete;
+
+  intrusive_index_list(intrusive_index_list&& other) noexcept
+      : base_(other.base_), head_(other.head_), tail_(other.tail_) {
+    other.head_ = intrusive_index_node::end;
+    other.tail_ = intrusive_index_node::end;
+  }
+
+  intrusive_index_list& operator=(intrusive_index_list&& other) noexcept {
+    clear();
+    base_ = other.base_;
+    head_ = other.head_;
+    tail_ = other.tail_;
+    other.head_ = intrusive_index_node::end;
+    other.tail_ = intrusive_index_node::end;
+    return *this;
+  }
+
+  // the arena must still be alive.
+  ~intrusive_index_list() { clear(); }
+
+  // Points the list at the arena's new address after it has been moved or reallocated. Nodes are
+  // not touched.
+  void rebase(pointer arena) noexcept { base_ = arena; }
+  pointer arena() const noexcept { return base_; }
+
+  [[nodiscard]] bool empty() const { return head_ == intrusive_index_node::end; }
+  [[nodiscard]] bool is_empty() const { return empty(); }
+
+  // O(n).
+  [[nodiscard]] size_type size() const {
+    size_type count = 0;
+    for (index_type i = head_; i != intrusive_index_node::end; i = node_at(i).next_) {
+      ++count;
+    }
+    return count;
+  }
+
+  reference front() {
+    assert(!empty());
+    return at(head_);
+  }
+
+  const_reference front() const {
+    assert(!empty());
+    return at(head_);
+  }
+
+  reference back() {
+    assert(!empty());
+    return at(tail_);
+  }
+
+  const_reference back() const {
+    assert(!empty());
+    return at(tail_);
+  }
+
+  void push_back(reference val) { link(tail_, index_of(val)); }
+  void push_front(reference val) { link(intrusive_index_node::end, index_of(val)); }
+
+  void insert_after(reference pos, reference val) {
+    assert((pos.*node_ptr).is_linked() && "inserting after a node that isn't in a list.");
+    link(index_of(pos), index_of(val));
+  }
+
+  void pop_front() {
+    assert(!empty());
+    unlink(head_);
+  }
+
+  void pop_back() {
+    assert(!empty());
+    unlink(tail_);
+  }
+
+  void erase(reference val) { unlink(index_of(val)); }
+  void erase(iterator pos) { unlink(pos.index()); }
+
+  void clear() {
+    index_type i = head_;
+    while (i != intrusive_index_node::end) {
+      intrusive_index_node& n = node_at(i);
+      i = n.next_;
+      n.next_ = intrusive_index_node::unlinked;
+      n.prev_ = intrusive_index_node::unlinked;
+    }
+    head_ = intrusive_index_node::end;
+    tail_ = intrusive_index_node::end;
+  }
+
+  iterator begin() { return iterator{this, head_}; }
+  const_iterator begin() const { return const_iterator{this, head_}; }
+  const_iterator cbegin() const { return begin(); }
+  iterator end() { return iterator{this, intrusive_index_node::end}; }
+  const_iterator end() const { return const_iterator{this, intrusive_index_node::end}; }
+  const_iterator cend() const { return end(); }
+
+  index_type index_of(const_reference val) const {
+    std::ptrdiff_t idx = &val - base_;
+    assert(idx >= 0 && static_cast<std::size_t>(idx) <= intrusive_index_node::max_index &&
+           "object is not in this list's arena.");
+    return static_cast<index_type>(idx);
+  }
+
+private:
+  template <typename, bool>
+  friend class pep::index_list_iterator;
+
+  reference at(index_type i) { return base_[i]; }
+  const_reference at(index_type i) const { return base_[i]; }
+  intrusive_index_node& node_at(index_type i) { return base_[i].*node_ptr; }
+  const intrusive_index_node& node_at(index_type i) const { return base_[i].*node_ptr; }
+
+  // links `i` after `pos`, or at the front if `pos` is end.
+  void link(index_type pos, index_type i) {
+    intrusive_index_node& n = node_at(i);
+    assert(!n.is_linked() && "this node is already part of a list.");
+    index_type next = pos == intrusive_index_node::end ? head_ : node_at(pos).next_;
+    n.prev_ = pos;
+    n.next_ = next;
+    if (pos == intrusive_index_node::end) {
+      head_ = i;
+    } else {
+      node_at(pos).next_ = i;
+    }
+    if (next == intrusive_index_node::end) {
+      tail_ = i;
+    } else {
+      node_at(next).prev_ = i;
+    }
+  }
+
+  void unlink(index_type i) {
+    intrusive_index_node& n = node_at(i);
+    assert(n.is_linked() && "erasing a node that isn't in a list.");
+    if (n.prev_ == intrusive_index_node::end) {
+      assert(head_ == i && "node is not in this list.");
+      head_ = n.next_;
+    } else {
+      node_at(n.prev_).next_ = n.next_;
+    }
+    if (n.next_ == intrusive_index_node::end) {
+      assert(tail_ == i && "node is not in this list.");
+      tail_ = n.prev_;
+    } else {
+      node_at(n.next_).prev_ = n.prev_;
+    }
+    n.next_ = intrusive_index_node::unlinked;
+    n.prev_ = intrusive_index_node::unlinked;
+  }
+
+  pointer base_;
+  index_type head_{intrusive_index_node::end};
+  index_type tail_{intrusive_index_node::end};
+};
+} // namespace pep
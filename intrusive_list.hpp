@@ -6,9 +6,14 @@
 
 #pragma once
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <type_traits>
 #include <utility>
+#if defined(_MSC_VER) && !defined(__clang__) && (defined(_M_X64) || defined(_M_IX86))
+#  include <xmmintrin.h>
+#endif
 #ifdef STUPIDLY_STD_COMPLIANT
 #  include <iterator>
 #else
@@ -19,55 +24,124 @@ struct bidirectional_iterator_tag;
 
 namespace pep {
 
-struct intrusive_node;
+enum class link_mode;
+template <link_mode Mode>
+struct basic_intrusive_node;
 namespace details {
-template <typename T1, typename T2>
-/*constexpr*/ size_t offset_of(T1 T2::*mem_p);
+template <typename T, typename Node, Node T::*mem_p>
+std::ptrdiff_t member_offset();
+template <typename T, typename Node, Node T::*mem_p>
+const T* owner_of(const Node* member);
 
 class ilist_base;
+class ilist_circular_base;
+struct size_option_kind;
+struct layout_option_kind;
 } // namespace details
 
-struct intrusive_node {
+// Options accepted by intrusive_list after the member pointer, in any order.
+
+// Keeps an element count in the list header so that size() is O(1), at the cost of one size_t per
+// list and a counter update on every link/unlink. Elements of a counted list must be unlinked
+// through the list; a node that removes itself in its destructor can't update the count.
+template <bool Enabled>
+struct constant_time_size {
+  using option_kind = details::size_option_kind;
+  static constexpr bool value = Enabled;
+};
+
+// Header layouts. The default linear layout keeps separate head and tail sentinels (4 pointers per
+// list). The circular layout uses a single sentinel that is both the node before begin() and end()
+// (2 pointers per list), so every linked node always has two neighbours and unlinking needs no
+// null checks.
+struct linear_layout {
+  using option_kind = details::layout_option_kind;
+  using base = details::ilist_base;
+};
+
+struct circular_layout {
+  using option_kind = details::layout_option_kind;
+  using base = details::ilist_circular_base;
+};
+
+// What a hook does about its links when it is unlinked or destroyed, chosen per hook type.
+enum class link_mode {
+  // Nothing. Erase is exactly two stores, clearing a list doesn't touch its elements, and
+  // destroying an element is free. A node keeps stale links once erased, so is_linked() is only
+  // meaningful before a node is first linked, and an element must be erased (or its list cleared)
+  // before it is destroyed.
+  normal,
+  // Links are nulled on unlink so is_linked() is reliable; destroying a linked node asserts.
+  safe,
+  // As safe, and a linked node unlinks itself when destroyed. The default.
+  auto_unlink,
+};
+
+namespace details {
+// The two links shared by every intrusive_list hook and by the lists' sentinels. Hooks add their
+// link_mode on top, see basic_intrusive_node.
+struct ilist_node {
 private:
   friend details::ilist_base;
-  intrusive_node* next_{nullptr};
-  intrusive_node* prev_{nullptr};
-
+  friend details::ilist_circular_base;
+  template <link_mode Mode>
+  friend struct pep::basic_intrusive_node;
+  ilist_node* next_{nullptr};
+  ilist_node* prev_{nullptr};
+
+  // writes the fields directly, a circular sentinel legitimately links to itself once its last
+  // element goes away.
   constexpr void remove_self() {
-    intrusive_node* prev_node = get_prev();
-    intrusive_node* next_node = get_next();
+    ilist_node* prev_node = get_prev();
+    ilist_node* next_node = get_next();
 
     if (prev_node != nullptr) {
-      prev_node->set_next(next_node);
+      prev_node->next_ = next_node;
     }
     if (next_node != nullptr) {
-      next_node->set_prev(prev_node);
+      next_node->prev_ = prev_node;
     }
     set_next(nullptr);
     set_prev(nullptr);
   }
 
-public:
-  constexpr intrusive_node() noexcept = default;
-  constexpr intrusive_node(const intrusive_node& other) = delete;
-  // no constexpr std::exchange, sad.
-  constexpr intrusive_node(intrusive_node&& other) noexcept {
-    // TODO
-    *this = std::move(other);
+  // links this node's neighbours to each other, leaving its own links stale. Only for nodes that
+  // are known to have both neighbours.
+  constexpr void bypass() {
+    prev_->next_ = next_;
+    next_->prev_ = prev_;
   }
 
-  ~intrusive_node() {
-    if (!is_linked()) {
-      return;
-    }
-    remove_self();
+  // links `a` straight to `b`. Written directly, a circular sentinel may be linked to itself.
+  static constexpr void link(ilist_node& a, ilist_node& b) {
+    a.next_ = &b;
+    b.prev_ = &a;
   }
 
-  constexpr intrusive_node& operator=(const intrusive_node&) = delete;
-  constexpr intrusive_node& operator=(intrusive_node&& other) noexcept {
-    if (&other == this) {
-      return *this;
-    }
+  // remove_self() for nodes that are known to have both neighbours.
+  constexpr void unlink() {
+    bypass();
+    next_ = nullptr;
+    prev_ = nullptr;
+  }
+
+  // moves the linked range [first, last] to just after `pos`, touching only the boundary nodes.
+  // `pos` must not be inside the range.
+  static constexpr void transfer_after(ilist_node& pos, ilist_node& first, ilist_node& last) {
+    ilist_node* before = first.prev_;
+    ilist_node* after = last.next_;
+    before->next_ = after;
+    after->prev_ = before;
+
+    ilist_node* next = pos.next_;
+    last.next_ = next;
+    next->prev_ = &last;
+    pos.next_ = &first;
+    first.prev_ = &pos;
+  }
+
+  // takes over the position of `other`, leaving it unlinked.
+  constexpr void take_links(ilist_node& other) {
     set_next(other.get_next());
     set_prev(other.get_prev());
     other.set_next(nullptr);
@@ -79,102 +153,225 @@ public:
       get_prev()->set_next(this);
     }
     assert(!other.is_linked());
-    return *this;
   }
 
-  // I can't do this, it becomes non-literal.
-  //  ~intrusive_node() { assert(!is_linked() && "destructor called on linked node."); }
+public:
+  constexpr ilist_node() noexcept = default;
+  constexpr ilist_node(const ilist_node&) = delete;
+  constexpr ilist_node& operator=(const ilist_node&) = delete;
 
-  constexpr intrusive_node* get_next() { return next_; }
-  constexpr intrusive_node* get_next() const { return next_; }
-  constexpr void set_next(intrusive_node* n) {
+  constexpr ilist_node* get_next() { return next_; }
+  constexpr ilist_node* get_next() const { return next_; }
+  constexpr void set_next(ilist_node* n) {
     assert(n != this && "attempted to link to self.");
     next_ = n;
   }
 
-  constexpr intrusive_node* get_prev() { return prev_; }
-  constexpr intrusive_node* get_prev() const { return prev_; }
-  constexpr void set_prev(intrusive_node* n) {
+  constexpr ilist_node* get_prev() { return prev_; }
+  constexpr ilist_node* get_prev() const { return prev_; }
+  constexpr void set_prev(ilist_node* n) {
     assert(n != this && "attempted to link to self.");
     prev_ = n;
   }
 
   constexpr bool is_linked() const {
-    intrusive_node* prev_node = get_prev();
-    intrusive_node* next_node = get_next();
+    ilist_node* prev_node = get_prev();
+    ilist_node* next_node = get_next();
     return (prev_node != nullptr) || (next_node != nullptr);
   }
 
   constexpr bool is_head() const {
-    intrusive_node* prev_node = get_prev();
+    ilist_node* prev_node = get_prev();
     return (prev_node != nullptr);
   }
 
   constexpr bool is_tail() const {
-    intrusive_node* next_node = get_next();
+    ilist_node* next_node = get_next();
     return (next_node != nullptr);
   }
+};
+} // namespace details
+
+// Hook for intrusive_list, two pointers. `Mode` picks what unlinking and destruction cost, see
+// link_mode; a list takes its mode from its hook.
+template <link_mode Mode>
+struct basic_intrusive_node : details::ilist_node {
+  static constexpr link_mode mode = Mode;
+
+  constexpr basic_intrusive_node() noexcept = default;
 
-  // ?? should this return const T*?
-  template <typename T, intrusive_node T::*mem_p>
+  // a linked node hands its position over, except in normal mode where links can't be trusted and
+  // the new node simply starts out unlinked.
+  constexpr basic_intrusive_node(basic_intrusive_node&& other) noexcept {
+    if constexpr (Mode != link_mode::normal) {
+      take_links(other);
+    }
+  }
+
+  constexpr basic_intrusive_node& operator=(basic_intrusive_node&& other) noexcept {
+    if constexpr (Mode != link_mode::normal) {
+      if (&other != this) {
+        assert((Mode == link_mode::auto_unlink || !is_linked()) &&
+               "overwriting a linked node.");
+        remove_self();
+        take_links(other);
+      }
+    }
+    return *this;
+  }
+
+  ~basic_intrusive_node() {
+    if constexpr (Mode == link_mode::auto_unlink) {
+      if (is_linked()) {
+        remove_self();
+      }
+    } else if constexpr (Mode == link_mode::safe) {
+      assert(!is_linked() && "destroying a linked node.");
+    }
+  }
+
+  // Unlinks this node from whatever list holds it, as the destructor does, without needing the
+  // list. A constant_time_size list doesn't see this and would lose count.
+  constexpr void remove_from_list() {
+    static_assert(Mode != link_mode::normal, "normal mode nodes don't know if they are linked.");
+    if (is_linked()) {
+      remove_self();
+    }
+  }
+
+  template <typename T, basic_intrusive_node T::*mem_p>
   const T* owner() const {
-    const char* this_addr = reinterpret_cast<const char*>(this);
-    // itanium abi only
-    // static constexpr size_t this_offset = details::offset_of(mem_p);
-#if __GNUC__ && !_WIN32
-    static_assert(sizeof(mem_p) == sizeof(ptrdiff_t));
-    ptrdiff_t this_offset = 0;
-    static constexpr intrusive_node T::*mem_p2 = mem_p;
-    // itanium abi stores pointers to members as just an offset with the size of a ptrdiff_t.
-    std::memcpy(&this_offset, &mem_p2, sizeof(mem_p2));
-    assert(this_offset >= 0 && "given a bad member pointer?");
-#else
-    // No idea if this will be optimized away like the above is.
-    size_t this_offset = details::offset_of(mem_p);
-#endif
-    const char* owner_addr = this_addr - this_offset;
-    assert(owner_addr <= this_addr);
-    assert(reinterpret_cast<std::uintptr_t>(owner_addr) % alignof(T) == 0);
-    return reinterpret_cast<const T*>(owner_addr);
+    return details::owner_of<T, basic_intrusive_node, mem_p>(this);
   }
 
-  template <typename T, intrusive_node T::*mem_p>
+  template <typename T, basic_intrusive_node T::*mem_p>
   T* owner() {
-    return const_cast<T*>(const_cast<const intrusive_node*>(this)->owner<T, mem_p>());
+    return const_cast<T*>(const_cast<const basic_intrusive_node*>(this)->owner<T, mem_p>());
   }
 };
 
+// The default hook: nodes automatically remove themselves from a list in their destructor.
+using intrusive_node = basic_intrusive_node<link_mode::auto_unlink>;
+
 namespace details {
 struct list_empty_t {};
-template <typename T1, typename T2>
-/*constexpr*/ size_t offset_of(T1 T2::*mem_p) {
-  union U {
-    char data[sizeof(T2)];
-    T2 v;
-
-    ~U() {}
-  } u{};
-
-  // workaround for gcc bug
-  bool found = false;
-  // https://stackoverflow.com/a/49776289/754018
-  const void* const desired_addr = static_cast<void const*>(std::addressof(u.v.*mem_p));
-  for (size_t i = 0; i != sizeof(T2); ++i) {
-    const void* const checking_addr = static_cast<void const*>(std::addressof(u.data[i]));
-    if (checking_addr == desired_addr) {
-      return i;
-    }
+
+// assumed cache line size, used to keep data written by different threads on separate lines.
+inline constexpr std::size_t cache_line_size = 64;
+
+// hints that the line holding `p` will be read soon. Never faults.
+inline void prefetch(const void* p) {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(p);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#else
+  static_cast<void>(p);
+#endif
+}
+
+// The byte offset of `mem_p` within T. C++17 can't read a member pointer in a constant expression,
+// but both ABIs in use store a data member pointer as the plain offset, so copying it out of a
+// constant leaves the optimizer nothing but that constant; dereferencing an iterator is then a
+// single subtraction.
+//   - Itanium (GCC, Clang, MinGW): a ptrdiff_t.
+//   - MSVC (cl, clang-cl): an int for classes without virtual bases. Classes with virtual bases,
+//     or member pointers formed while T was incomplete, get a wider representation; those can
+//     use intrusive_base_node instead.
+template <typename T, typename Node, Node T::*mem_p>
+std::ptrdiff_t member_offset() {
+  static constexpr Node T::*ptr = mem_p;
+#if defined(_MSC_VER)
+  static_assert(sizeof(ptr) == sizeof(int),
+                "member pointer isn't a plain offset, does T have virtual bases?");
+  int offset = 0;
+#else
+  static_assert(sizeof(ptr) == sizeof(std::ptrdiff_t), "not an Itanium ABI member pointer.");
+  std::ptrdiff_t offset = 0;
+#endif
+  std::memcpy(&offset, &ptr, sizeof(ptr));
+  assert(offset >= 0 && "given a bad member pointer?");
+  return offset;
+}
+
+// Recovers the T that `member` is the `mem_p` member of. Shared by every hook type.
+template <typename T, typename Node, Node T::*mem_p>
+const T* owner_of(const Node* member) {
+  const char* this_addr = reinterpret_cast<const char*>(member);
+  const char* owner_addr = this_addr - member_offset<T, Node, mem_p>();
+  assert(owner_addr <= this_addr);
+  assert(reinterpret_cast<std::uintptr_t>(owner_addr) % alignof(T) == 0);
+  return reinterpret_cast<const T*>(owner_addr);
+}
+
+} // namespace details
+
+// Base hook: an intrusive_node that T inherits from instead of holding as a member. Inheriting
+// several with different tags puts T in several lists at once, and the owner is recovered with a
+// static_cast rather than from a member offset.
+template <typename Tag = void, link_mode Mode = link_mode::auto_unlink>
+struct intrusive_base_node : basic_intrusive_node<Mode> {
+  constexpr intrusive_base_node() noexcept = default;
+  intrusive_base_node(intrusive_base_node&&) noexcept = default;
+  intrusive_base_node& operator=(intrusive_base_node&&) noexcept = default;
+};
+
+namespace details {
+// the member pointer type's class and member.
+template <typename MemberPtr>
+struct member_ptr_traits;
+
+template <typename T, typename Member>
+struct member_ptr_traits<Member T::*> {
+  using owner_type = T;
+  using member_type = Member;
+};
+
+// the intrusive_base_node<Tag, Mode> base of T, whatever its mode.
+template <typename Tag, link_mode Mode>
+intrusive_base_node<Tag, Mode>* base_node_of(intrusive_base_node<Tag, Mode>*);
+} // namespace details
+
+// How intrusive_list gets from an element to its hook and back. `node_type` is the hook type,
+// which carries the link_mode.
+
+// the `node_ptr` member of T.
+template <typename T, typename Node, Node T::*node_ptr>
+struct member_hook {
+  using node_type = Node;
+
+  static node_type& node_of(T& val) { return val.*node_ptr; }
+  static T* owner_of(details::ilist_node* n) {
+    return static_cast<node_type*>(n)->template owner<T, node_ptr>();
   }
-  if (!found) {
-    throw 0;
+  static const T* owner_of(const details::ilist_node* n) {
+    return static_cast<const node_type*>(n)->template owner<T, node_ptr>();
   }
-  return -1u;
-}
+};
 
+namespace details {
+template <typename T, auto node_ptr>
+using member_hook_for =
+  member_hook<T, typename member_ptr_traits<decltype(node_ptr)>::member_type, node_ptr>;
 } // namespace details
 
-template <typename T, intrusive_node T::*node_ptr, bool isConst = false>
-class list_iterator {
+// the intrusive_base_node<Tag, Mode> base of T.
+template <typename T, typename Tag = void>
+struct base_hook {
+  using node_type =
+    std::remove_pointer_t<decltype(details::base_node_of<Tag>(static_cast<T*>(nullptr)))>;
+
+  static node_type& node_of(T& val) { return static_cast<node_type&>(val); }
+  static T* owner_of(details::ilist_node* n) {
+    return static_cast<T*>(static_cast<node_type*>(n));
+  }
+  static const T* owner_of(const details::ilist_node* n) {
+    return static_cast<const T*>(static_cast<const node_type*>(n));
+  }
+};
+
+template <typename T, typename Hook, bool isConst = false>
+class basic_list_iterator {
 public:
   using value_type = std::conditional_t<isConst, const T, T>;
   using pointer = value_type*;
@@ -182,51 +379,58 @@ public:
   using difference_type = std::ptrdiff_t;
   using iterator_category = std::bidirectional_iterator_tag;
 
-  using node = std::conditional_t<isConst, const intrusive_node, intrusive_node>;
+  using node = std::conditional_t<isConst, const details::ilist_node, details::ilist_node>;
   node* ptr_;
 
-  explicit list_iterator(node* ptr) : ptr_(ptr) {}
+  explicit basic_list_iterator(node* ptr) : ptr_(ptr) {}
+
+  // iterator -> const_iterator.
+  template <bool wasConst, typename = std::enable_if_t<isConst && !wasConst>>
+  basic_list_iterator(const basic_list_iterator<T, Hook, wasConst>& other) : ptr_(other.ptr_) {}
 
   reference operator*() {
     assert(ptr_ != nullptr);
-    return *(ptr_->template owner<T, node_ptr>());
+    return *Hook::owner_of(ptr_);
   }
 
-  pointer operator->() { return ptr_->template owner<T, node_ptr>(); }
+  pointer operator->() { return Hook::owner_of(ptr_); }
 
-  list_iterator& operator++() {
+  basic_list_iterator& operator++() {
     assert(ptr_);
     ptr_ = ptr_->get_next();
     return *this;
   }
 
-  list_iterator operator++(int) {
+  basic_list_iterator operator++(int) {
     operator++();
     return *this;
   }
 
-  list_iterator& operator--() {
+  basic_list_iterator& operator--() {
     assert(ptr_);
     ptr_ = ptr_->get_prev();
     return *this;
   }
 
-  list_iterator operator--(int) {
+  basic_list_iterator operator--(int) {
     operator--();
     return *this;
   }
 
-  constexpr difference_type operator-(const list_iterator& rhs) { return ptr_ - rhs.ptr_; }
+  constexpr difference_type operator-(const basic_list_iterator& rhs) { return ptr_ - rhs.ptr_; }
 
-  constexpr bool operator==(const list_iterator& rhs) const { return ptr_ == rhs.ptr_; }
-  constexpr bool operator!=(const list_iterator& rhs) const { return !(*this == rhs); }
+  constexpr bool operator==(const basic_list_iterator& rhs) const { return ptr_ == rhs.ptr_; }
+  constexpr bool operator!=(const basic_list_iterator& rhs) const { return !(*this == rhs); }
 
-  constexpr bool operator<(const list_iterator& rhs) const { return (rhs - *this) > 0; }
-  constexpr bool operator>(const list_iterator& rhs) const { return rhs < *this; }
-  constexpr bool operator<=(const list_iterator& rhs) const { return !(*this > rhs); }
-  constexpr bool operator>=(const list_iterator& rhs) const { return !(*this < rhs); }
+  constexpr bool operator<(const basic_list_iterator& rhs) const { return (rhs - *this) > 0; }
+  constexpr bool operator>(const basic_list_iterator& rhs) const { return rhs < *this; }
+  constexpr bool operator<=(const basic_list_iterator& rhs) const { return !(*this > rhs); }
+  constexpr bool operator>=(const basic_list_iterator& rhs) const { return !(*this < rhs); }
 };
 
+template <typename T, auto node_ptr, bool isConst = false>
+using list_iterator = basic_list_iterator<T, details::member_hook_for<T, node_ptr>, isConst>;
+
 // TODO: move functions that don't depend on node_ptr to base class to reduce
 // template instantiations.
 
@@ -234,6 +438,7 @@ namespace details {
 class ilist_base {
 public:
   using difference_type = std::ptrdiff_t;
+  using size_type = std::size_t;
 
   inline ilist_base() noexcept;
 
@@ -247,26 +452,44 @@ public:
 
   [[nodiscard]] inline bool empty() const;
   [[nodiscard]] inline bool is_empty() const;
-  // [[nodiscard]] inline difference_type size() const;
-  inline void insert_after(intrusive_node& pos, intrusive_node& val);
+  // O(n), see constant_time_size.
+  [[nodiscard]] inline size_type size() const;
+  inline void insert_after(ilist_node& pos, ilist_node& val);
   inline void pop_front();
   inline void pop_back();
 
-  inline void erase(intrusive_node* n);
+  inline void erase(ilist_node* n);
   inline void clear();
 
 protected:
-  inline void node_invariant(intrusive_node* n) const;
+  inline void node_invariant(ilist_node* n) const;
   inline void modification_invariant() const;
 
-  intrusive_node head_{};
-  intrusive_node tail_{};
+  inline void transfer_after(ilist_node& pos, ilist_node& first, ilist_node& last);
+  // unlinks `n` without resetting its own links.
+  inline void bypass(ilist_node* n);
+  // links `before` straight to `after`, dropping the nodes between them without touching them.
+  inline void bridge(ilist_node& before, ilist_node& after);
+  // empties the list without touching its elements.
+  inline void reset() noexcept;
+
+  ilist_node* before_begin_node() { return &head_; }
+  const ilist_node* before_begin_node() const { return &head_; }
+  ilist_node* end_node() { return &tail_; }
+  const ilist_node* end_node() const { return &tail_; }
+
+  ilist_node head_{};
+  ilist_node tail_{};
 
 private:
   inline void move_from(ilist_base& other) noexcept;
 };
 
 inline ilist_base::ilist_base() noexcept {
+  reset();
+}
+
+inline void ilist_base::reset() noexcept {
   head_.set_next(std::addressof(tail_));
   tail_.set_prev(std::addressof(head_));
 }
@@ -311,17 +534,20 @@ inline bool ilist_base::is_empty() const {
   return head_.get_next() == &tail_;
 }
 
-// inline ilist_base::difference_type ilist_base::size() const {
-//   return size_;
-// }
+inline ilist_base::size_type ilist_base::size() const {
+  size_type count = 0;
+  for (const ilist_node* n = head_.get_next(); n != &tail_; n = n->get_next()) {
+    ++count;
+  }
+  return count;
+}
 
-inline void ilist_base::insert_after(intrusive_node& pos, intrusive_node& val) {
+inline void ilist_base::insert_after(ilist_node& pos, ilist_node& val) {
   node_invariant(&val);
   node_invariant(&pos);
-  // ++size_;
   assert(!val.is_linked() && "this node is already part of a list.");
 
-  intrusive_node& next = *pos.get_next();
+  ilist_node& next = *pos.get_next();
   assert(next.get_prev() == &pos && "sanity error");
   val.set_next(&next);
   val.set_prev(&pos);
@@ -330,39 +556,70 @@ inline void ilist_base::insert_after(intrusive_node& pos, intrusive_node& val) {
 }
 
 inline void ilist_base::pop_front() {
-  intrusive_node* real_head = head_.get_next();
+  ilist_node* real_head = head_.get_next();
   assert(real_head->is_linked());
   erase(real_head);
 }
 
 inline void ilist_base::pop_back() {
-  intrusive_node* real_tail = tail_.get_prev();
+  ilist_node* real_tail = tail_.get_prev();
   assert(real_tail->is_linked());
   erase(real_tail);
 }
 
-inline void ilist_base::erase(intrusive_node* n) {
+inline void ilist_base::erase(ilist_node* n) {
   modification_invariant();
   assert(n != &head_ && "Invalid node.");
   assert(n != &tail_ && "Invalid node.");
   node_invariant(n);
   n->remove_self();
   node_invariant(n);
-  // --size_;
+}
+
+inline void ilist_base::bypass(ilist_node* n) {
+  modification_invariant();
+  assert(n != &head_ && "Invalid node.");
+  assert(n != &tail_ && "Invalid node.");
+  node_invariant(n);
+  n->bypass();
+}
+
+inline void ilist_base::bridge(ilist_node& before, ilist_node& after) {
+  modification_invariant();
+  assert(&before != &tail_ && "Invalid node.");
+  assert(&after != &head_ && "Invalid node.");
+  ilist_node::link(before, after);
+}
+
+inline void ilist_base::transfer_after(ilist_node& pos, ilist_node& first,
+                                       ilist_node& last) {
+  modification_invariant();
+  assert(&pos != &tail_ && "can't insert after the tail sentinel.");
+  node_invariant(&pos);
+  node_invariant(&first);
+  node_invariant(&last);
+  // already in place.
+  if (pos.get_next() == &first || &pos == &last) {
+    return;
+  }
+  ilist_node::transfer_after(pos, first, last);
+  node_invariant(&first);
+  node_invariant(&last);
 }
 
 inline void ilist_base::clear() {
-  intrusive_node* n = head_.get_next();
+  // every node goes, so only their own links need resetting, not their neighbours'.
+  ilist_node* n = head_.get_next();
   while (n != &tail_) {
-    intrusive_node* prev = n;
+    ilist_node* prev = n;
     n = n->get_next();
-    prev->remove_self();
+    prev->set_next(nullptr);
+    prev->set_prev(nullptr);
   }
-  head_.set_next(&tail_);
-  tail_.set_prev(&head_);
+  reset();
 }
 
-inline void ilist_base::node_invariant(intrusive_node* n) const {
+inline void ilist_base::node_invariant(ilist_node* n) const {
 #ifndef NDEBUG
   if (!n->is_linked()) {
     assert(n->get_next() == nullptr);
@@ -388,14 +645,376 @@ inline void ilist_base::modification_invariant() const {
   assert(head_.get_next() != nullptr);
 #endif
 }
+
+class ilist_circular_base {
+public:
+  using difference_type = std::ptrdiff_t;
+  using size_type = std::size_t;
+
+  inline ilist_circular_base() noexcept;
+
+  ilist_circular_base(const ilist_circular_base&) = delete;
+  ilist_circular_base& operator=(const ilist_circular_base&) = delete;
+
+  inline ilist_circular_base(ilist_circular_base&& other) noexcept;
+  inline ilist_circular_base& operator=(ilist_circular_base&&) noexcept;
+
+  inline ~ilist_circular_base();
+
+  [[nodiscard]] inline bool empty() const;
+  [[nodiscard]] inline bool is_empty() const;
+  // O(n), see constant_time_size.
+  [[nodiscard]] inline size_type size() const;
+  inline void insert_after(ilist_node& pos, ilist_node& val);
+  inline void pop_front();
+  inline void pop_back();
+
+  inline void erase(ilist_node* n);
+  inline void clear();
+
+protected:
+  inline void node_invariant(ilist_node* n) const;
+  inline void modification_invariant() const;
+
+  inline void transfer_after(ilist_node& pos, ilist_node& first, ilist_node& last);
+  // unlinks `n` without resetting its own links.
+  inline void bypass(ilist_node* n);
+  // links `before` straight to `after`, dropping the nodes between them without touching them.
+  inline void bridge(ilist_node& before, ilist_node& after);
+  // empties the list without touching its elements.
+  inline void reset() noexcept;
+
+  ilist_node* before_begin_node() { return &root_; }
+  const ilist_node* before_begin_node() const { return &root_; }
+  ilist_node* end_node() { return &root_; }
+  const ilist_node* end_node() const { return &root_; }
+
+  ilist_node root_{};
+
+private:
+  inline void move_from(ilist_circular_base& other) noexcept;
+};
+
+inline ilist_circular_base::ilist_circular_base() noexcept {
+  reset();
+}
+
+inline void ilist_circular_base::reset() noexcept {
+  // the sentinel links to itself, which set_next/set_prev refuse to do.
+  root_.next_ = &root_;
+  root_.prev_ = &root_;
+}
+
+inline void ilist_circular_base::move_from(ilist_circular_base& other) noexcept {
+  if (other.empty()) {
+    reset();
+  } else {
+    root_.next_ = other.root_.next_;
+    root_.prev_ = other.root_.prev_;
+    root_.next_->prev_ = &root_;
+    root_.prev_->next_ = &root_;
+  }
+  other.reset();
+  assert(other.empty());
+}
+
+inline ilist_circular_base::ilist_circular_base(ilist_circular_base&& other) noexcept {
+  move_from(other);
+}
+
+inline auto ilist_circular_base::operator=(ilist_circular_base&& other) noexcept
+  -> ilist_circular_base& {
+  clear();
+  move_from(other);
+  return *this;
+}
+
+inline ilist_circular_base::~ilist_circular_base() {
+  if (!empty()) {
+    clear();
+  }
+}
+
+inline bool ilist_circular_base::empty() const {
+  return is_empty();
+}
+
+inline bool ilist_circular_base::is_empty() const {
+  return root_.get_next() == &root_;
+}
+
+inline ilist_circular_base::size_type ilist_circular_base::size() const {
+  size_type count = 0;
+  for (const ilist_node* n = root_.get_next(); n != &root_; n = n->get_next()) {
+    ++count;
+  }
+  return count;
+}
+
+inline void ilist_circular_base::insert_after(ilist_node& pos, ilist_node& val) {
+  node_invariant(&val);
+  node_invariant(&pos);
+  assert(!val.is_linked() && "this node is already part of a list.");
+  assert(&val != &root_ && "Invalid node.");
+
+  ilist_node& next = *pos.next_;
+  assert(next.prev_ == &pos && "sanity error");
+  val.next_ = &next;
+  val.prev_ = &pos;
+  pos.next_ = &val;
+  next.prev_ = &val;
+}
+
+inline void ilist_circular_base::pop_front() {
+  assert(!empty());
+  erase(root_.get_next());
+}
+
+inline void ilist_circular_base::pop_back() {
+  assert(!empty());
+  erase(root_.get_prev());
+}
+
+inline void ilist_circular_base::erase(ilist_node* n) {
+  modification_invariant();
+  assert(n != &root_ && "Invalid node.");
+  node_invariant(n);
+  n->unlink();
+  node_invariant(n);
+}
+
+inline void ilist_circular_base::bypass(ilist_node* n) {
+  modification_invariant();
+  assert(n != &root_ && "Invalid node.");
+  node_invariant(n);
+  n->bypass();
+}
+
+inline void ilist_circular_base::bridge(ilist_node& before, ilist_node& after) {
+  modification_invariant();
+  ilist_node::link(before, after);
+}
+
+inline void ilist_circular_base::transfer_after(ilist_node& pos, ilist_node& first,
+                                                ilist_node& last) {
+  modification_invariant();
+  node_invariant(&pos);
+  node_invariant(&first);
+  node_invariant(&last);
+  // already in place.
+  if (pos.get_next() == &first || &pos == &last) {
+    return;
+  }
+  ilist_node::transfer_after(pos, first, last);
+  node_invariant(&first);
+  node_invariant(&last);
+}
+
+inline void ilist_circular_base::clear() {
+  ilist_node* n = root_.get_next();
+  while (n != &root_) {
+    ilist_node* prev = n;
+    n = n->get_next();
+    prev->set_next(nullptr);
+    prev->set_prev(nullptr);
+  }
+  reset();
+}
+
+inline void ilist_circular_base::node_invariant(ilist_node* n) const {
+#ifndef NDEBUG
+  if (!n->is_linked()) {
+    assert(n->get_next() == nullptr);
+    assert(n->get_prev() == nullptr);
+    return;
+  }
+  assert(n->get_next() != nullptr && "sanity error");
+  assert(n->get_prev() != nullptr && "sanity error");
+  assert(n->get_next()->get_prev() == n && "sanity error");
+  assert(n->get_prev()->get_next() == n && "sanity error");
+#else
+  static_cast<void>(n);
+#endif
+}
+
+inline void ilist_circular_base::modification_invariant() const {
+#ifndef NDEBUG
+  assert(root_.get_prev() != nullptr);
+  assert(root_.get_next() != nullptr);
+#endif
+}
+
+// Adds element counting on top of a list base when constant_time_size<true> is requested. The
+// uncounted variant adds nothing, not even storage.
+template <typename Base, bool ConstantTimeSize>
+class ilist_counter : public Base {
+protected:
+  void size_add(typename Base::size_type) {}
+  void size_sub(typename Base::size_type) {}
+};
+
+template <typename Base>
+class ilist_counter<Base, true> : public Base {
+public:
+  using typename Base::size_type;
+
+  ilist_counter() noexcept = default;
+
+  ilist_counter(ilist_counter&& other) noexcept : Base(std::move(other)), size_(other.size_) {
+    other.size_ = 0;
+  }
+
+  ilist_counter& operator=(ilist_counter&& other) noexcept {
+    Base::operator=(std::move(other));
+    size_ = other.size_;
+    other.size_ = 0;
+    return *this;
+  }
+
+  [[nodiscard]] size_type size() const { return size_; }
+
+  void insert_after(ilist_node& pos, ilist_node& val) {
+    Base::insert_after(pos, val);
+    ++size_;
+  }
+
+  void pop_front() {
+    Base::pop_front();
+    --size_;
+  }
+
+  void pop_back() {
+    Base::pop_back();
+    --size_;
+  }
+
+  void erase(ilist_node* n) {
+    Base::erase(n);
+    --size_;
+  }
+
+  void clear() {
+    Base::clear();
+    size_ = 0;
+  }
+
+protected:
+  void reset() noexcept {
+    Base::reset();
+    size_ = 0;
+  }
+
+  void size_add(size_type n) { size_ += n; }
+  void size_sub(size_type n) { size_ -= n; }
+
+private:
+  size_type size_{0};
+};
+
+// Merges two sorted chains terminated by a null next pointer, ignoring prev pointers. Stable: on
+// ties elements of `a` come first.
+template <typename Less>
+ilist_node* merge_chains(ilist_node* a, ilist_node* b, Less& less) {
+  if (a == nullptr) {
+    return b;
+  }
+  if (b == nullptr) {
+    return a;
+  }
+  ilist_node* head;
+  if (less(*b, *a)) {
+    head = b;
+    b = b->get_next();
+  } else {
+    head = a;
+    a = a->get_next();
+  }
+  ilist_node* tail = head;
+  while (a != nullptr && b != nullptr) {
+    if (less(*b, *a)) {
+      tail->set_next(b);
+      tail = b;
+      b = b->get_next();
+    } else {
+      tail->set_next(a);
+      tail = a;
+      a = a->get_next();
+    }
+  }
+  tail->set_next(a != nullptr ? a : b);
+  return head;
+}
+
+// Bottom-up merge sort of a null-terminated chain. bins[i] holds a sorted run of 2^i nodes, so the
+// only extra space is one pointer per bit of the element count.
+template <typename Less>
+ilist_node* sort_chain(ilist_node* first, Less& less) {
+  constexpr std::size_t bin_count = sizeof(std::size_t) * 8;
+  ilist_node* bins[bin_count] = {};
+  std::size_t used = 0;
+  while (first != nullptr) {
+    ilist_node* carry = first;
+    first = first->get_next();
+    carry->set_next(nullptr);
+    std::size_t i = 0;
+    // bins hold earlier elements than carry, they go first to keep the sort stable.
+    for (; i != used && bins[i] != nullptr; ++i) {
+      carry = merge_chains(bins[i], carry, less);
+      bins[i] = nullptr;
+    }
+    bins[i] = carry;
+    if (i == used) {
+      ++used;
+    }
+  }
+  ilist_node* result = nullptr;
+  for (std::size_t i = 0; i != used; ++i) {
+    result = merge_chains(bins[i], result, less);
+  }
+  return result;
+}
+
+template <typename Kind, typename Default, typename... Options>
+struct find_option {
+  using type = Default;
+};
+
+template <typename Kind, typename Default, typename Option, typename... Options>
+struct find_option<Kind, Default, Option, Options...> {
+  using type = std::conditional_t<std::is_same<typename Option::option_kind, Kind>::value, Option,
+                                  typename find_option<Kind, Default, Options...>::type>;
+};
+
+template <typename... Options>
+struct list_options {
+  static constexpr bool constant_time_size =
+    find_option<size_option_kind, pep::constant_time_size<false>, Options...>::type::value;
+  using layout = typename find_option<layout_option_kind, pep::linear_layout, Options...>::type;
+
+  using base = ilist_counter<typename layout::base, constant_time_size>;
+};
 } // namespace details
 
-template <typename T, intrusive_node T::*node_ptr>
-class intrusive_list : public details::ilist_base {
-  using details::ilist_base::erase;
+// Doubly linked list of T, reaching each element's hook through `Hook`. Use it through
+// intrusive_list (member hooks) or intrusive_base_list (base hooks). The hook type's link_mode
+// decides what erase, clear and the list's destructor do to unlinked nodes.
+template <typename T, typename Hook, typename... Options>
+class basic_intrusive_list : public details::list_options<Options...>::base {
+  using base = typename details::list_options<Options...>::base;
+  using options = details::list_options<Options...>;
+  using base::before_begin_node;
+  using base::bridge;
+  using base::end_node;
+  using base::erase;
+  using base::modification_invariant;
+  using base::size_add;
+  using base::size_sub;
+  using base::transfer_after;
+  using node = details::ilist_node;
 
 public:
-  using details::ilist_base::insert_after;
+  using base::empty;
+  using base::insert_after;
 
   using value_type = T;
   using reference = value_type&;
@@ -405,69 +1024,428 @@ public:
   using difference_type = std::ptrdiff_t;
   using size_type = std::size_t;
 
-  using iterator = pep::list_iterator<T, node_ptr>;
-  using const_iterator = pep::list_iterator<T, node_ptr, true>;
+  using iterator = pep::basic_list_iterator<T, Hook>;
+  using const_iterator = pep::basic_list_iterator<T, Hook, true>;
+
+  static constexpr link_mode mode = Hook::node_type::mode;
+
+  basic_intrusive_list() noexcept = default;
+  basic_intrusive_list(basic_intrusive_list&&) noexcept = default;
+
+  basic_intrusive_list& operator=(basic_intrusive_list&& other) noexcept {
+    clear();
+    base::operator=(std::move(other));
+    return *this;
+  }
+
+  ~basic_intrusive_list() { clear(); }
 
   reference front() {
     assert(!empty());
-    return *(head_.get_next()->template owner<T, node_ptr>());
+    return *Hook::owner_of(before_begin_node()->get_next());
   }
 
   const_reference front() const {
     assert(!empty());
-    return *(head_.get_next()->template owner<T, node_ptr>());
+    return *Hook::owner_of(before_begin_node()->get_next());
   }
 
   reference back() {
     assert(!empty());
-    return *(tail_.get_prev()->template owner<T, node_ptr>());
+    return *Hook::owner_of(end_node()->get_prev());
   }
 
   const_reference back() const {
     assert(!empty());
-    return *(tail_.get_prev()->template owner<T, node_ptr>());
+    return *Hook::owner_of(end_node()->get_prev());
   }
 
   void push_back(reference val) {
-    intrusive_node* real_tail = tail_.get_prev();
+    modification_invariant();
+    node* real_tail = end_node()->get_prev();
     assert(real_tail->is_linked() && "sanity error");
-    insert_after(real_tail->owner<T, node_ptr>(), val);
+    link_after(*real_tail, Hook::node_of(val));
   }
 
-  void push_front(reference val) { insert_after(head_, val.*node_ptr); }
+  void push_front(reference val) { link_after(*before_begin_node(), Hook::node_of(val)); }
+
+  void pop_front() {
+    assert(!empty());
+    unlink(before_begin_node()->get_next());
+  }
+
+  void pop_back() {
+    assert(!empty());
+    unlink(end_node()->get_prev());
+  }
 
   void insert_after(pointer pos, reference val) {
     modification_invariant();
     assert(pos != nullptr && "can't insert after a null pointer.");
 
-    intrusive_node& pos_node = pos->*node_ptr;
-    intrusive_node& n = val.*node_ptr;
-    return insert_after(pos_node, n);
+    node& pos_node = Hook::node_of(*pos);
+    node& n = Hook::node_of(val);
+    return link_after(pos_node, n);
   }
 
   void insert_after(const_iterator pos, reference val) {
     // can't insert anything after `end`.
     assert(pos != end());
-    intrusive_node& pos_node = (*pos).*node_ptr;
-    intrusive_node& n = val->*node_ptr;
-    return insert_after(pos_node, n);
+    node& pos_node = *const_cast<node*>(pos.ptr_);
+    node& n = Hook::node_of(val);
+    return link_after(pos_node, n);
+  }
+
+  // Links the elements of [first, last) in order at the back. The incoming hooks are chained to
+  // each other first and the chain is attached with one update at each end, so the list's own
+  // nodes are touched once per call instead of once per element. `first` and `last` iterate over
+  // T& or T*.
+  template <typename InputIt>
+  void push_back_range(InputIt first, InputIt last) {
+    link_range_after(*end_node()->get_prev(), first, last);
+  }
+
+  // Links the elements of [first, last) in order after `pos`, as push_back_range() does.
+  template <typename InputIt>
+  void insert_after(const_iterator pos, InputIt first, InputIt last) {
+    // can't insert anything after `end`.
+    assert(pos != end());
+    link_range_after(*const_cast<node*>(pos.ptr_), first, last);
+  }
+
+  void erase(iterator pos) { unlink(&Hook::node_of(*pos)); }
+
+  void erase(reference pos) { unlink(&Hook::node_of(pos)); }
+
+  // Unlinks the elements of [first, last), which must all be in this list, and returns how many
+  // there were. `first` and `last` iterate over T& or T*. Each element is relinked around on its
+  // own, in one pass; a counted list adjusts its size once.
+  template <typename InputIt>
+  size_type erase_many(InputIt first, InputIt last) {
+    size_type removed = 0;
+    for (; first != last; ++first) {
+      node* n = &Hook::node_of(element(*first));
+      if constexpr (mode == link_mode::normal) {
+        base::bypass(n);
+      } else {
+        // uncounted, the size is adjusted once below.
+        options::layout::base::erase(n);
+      }
+      ++removed;
+    }
+    size_sub(removed);
+    return removed;
+  }
+
+  // Unlinks every element for which `pred` returns true and returns how many there were. One pass:
+  // each run of adjacent matches is cut out with one update at either end, so surviving elements
+  // are not written to except where a run ends next to them. If `pred` throws, the elements
+  // removed so far stay removed and the list is otherwise unchanged.
+  template <typename Pred>
+  size_type remove_if(Pred pred) {
+    return remove_if_and_dispose(std::move(pred), [](reference) {});
+  }
+
+  // remove_if() that passes each removed element to `dispose` once it is out of the list, which
+  // may destroy it.
+  template <typename Pred, typename Disposer>
+  size_type remove_if_and_dispose(Pred pred, Disposer dispose) {
+    modification_invariant();
+    node* const end = end_node();
+    node* kept = before_begin_node();
+    node* n = kept->get_next();
+    size_type removed = 0;
+    while (n != end) {
+      if (!pred(*Hook::owner_of(n))) {
+        kept = n;
+        n = n->get_next();
+        continue;
+      }
+      node* run = n;
+      size_type count = 0;
+      do {
+        n = n->get_next();
+        ++count;
+      } while (n != end && pred(*Hook::owner_of(n)));
+      bridge(*kept, *n);
+      size_sub(count);
+      removed += count;
+      while (run != n) {
+        node* next = run->get_next();
+        if constexpr (mode != link_mode::normal) {
+          run->set_next(nullptr);
+          run->set_prev(nullptr);
+        }
+        dispose(*Hook::owner_of(run));
+        run = next;
+      }
+    }
+    return removed;
+  }
+
+  // Unlinks every element. O(n), or O(1) in normal link mode where elements are left as they are.
+  void clear() {
+    if constexpr (mode == link_mode::normal) {
+      base::reset();
+    } else {
+      base::clear();
+    }
+  }
+
+  // Unlinks every element and passes it to `dispose`, which may destroy it, in the same pass. The
+  // list is already empty when the first element is disposed of.
+  template <typename Disposer>
+  void clear_and_dispose(Disposer dispose) {
+    node* const end = end_node();
+    node* n = before_begin_node()->get_next();
+    base::reset();
+    while (n != end) {
+      node* next = n->get_next();
+      if constexpr (mode != link_mode::normal) {
+        n->set_next(nullptr);
+        n->set_prev(nullptr);
+      }
+      dispose(*Hook::owner_of(n));
+      n = next;
+    }
+  }
+
+  // Empties the list in O(1) without touching its elements, for tearing down a list whose
+  // elements' storage is released wholesale, as with an arena. The elements keep their stale
+  // links: outside normal link mode they still look linked and can't go into a list again, and
+  // destroying an auto_unlink one would write into its old neighbours.
+  void forget() noexcept { base::reset(); }
+
+  // Moves every element of `other` in front of `pos`. O(1).
+  void splice(const_iterator pos, basic_intrusive_list& other) {
+    assert(&other != this && "can't splice a list into itself.");
+    if (other.empty()) {
+      return;
+    }
+    size_type n = options::constant_time_size ? other.size() : 0;
+    transfer_after(*node_before(pos), *other.before_begin_node()->get_next(),
+                   *other.end_node()->get_prev());
+    size_add(n);
+    other.size_sub(n);
+  }
+
+  // Moves [first, last) of `other` in front of `pos`. `other` may be this list, as long as `pos`
+  // is not inside the range. O(1), or O(distance(first, last)) between two counted lists.
+  void splice(const_iterator pos, basic_intrusive_list& other, const_iterator first,
+              const_iterator last) {
+    if (first == last) {
+      return;
+    }
+    size_type n = 0;
+    if (options::constant_time_size && &other != this) {
+      for (const_iterator it = first; it != last; ++it) {
+        ++n;
+      }
+    }
+    transfer_after(*node_before(pos), *const_cast<node*>(first.ptr_),
+                   *node_before(last));
+    size_add(n);
+    other.size_sub(n);
+  }
+
+  // Moves the single element at `it` in front of `pos`. O(1).
+  void splice(const_iterator pos, basic_intrusive_list& other, const_iterator it) {
+    assert(it != other.end());
+    node& n = *const_cast<node*>(it.ptr_);
+    transfer_after(*node_before(pos), n, n);
+    if (&other != this) {
+      size_add(1);
+      other.size_sub(1);
+    }
+  }
+
+  // Relinks the element `val` of this list as its last element, the touch operation of an LRU.
+  // O(1), equivalent to erase(val) followed by push_back(val).
+  void move_to_back(reference val) {
+    node& n = Hook::node_of(val);
+    transfer_after(*end_node()->get_prev(), n, n);
   }
 
-  void erase(iterator pos) {
-    intrusive_node* n = &((*pos).*node_ptr);
-    erase(n);
+  // Relinks the element `val` of this list as its first element. O(1).
+  void move_to_front(reference val) {
+    node& n = Hook::node_of(val);
+    transfer_after(*before_begin_node(), n, n);
   }
 
-  void erase(reference pos) {
-    intrusive_node* n = &(pos.*node_ptr);
-    erase(n);
+  // Stable merge sort that only relinks nodes, elements are never moved or copied and nothing is
+  // allocated. O(n log n) comparisons. `comp` must not throw.
+  template <typename Compare>
+  void sort(Compare comp) {
+    node* head = before_begin_node();
+    node* tail = end_node();
+    if (empty() || head->get_next() == tail->get_prev()) {
+      return;
+    }
+    auto less = [&comp](const node& a, const node& b) {
+      return comp(*Hook::owner_of(&a), *Hook::owner_of(&b));
+    };
+    node* first = head->get_next();
+    tail->get_prev()->set_next(nullptr);
+    first = details::sort_chain(first, less);
+
+    // rebuild the prev pointers.
+    node* prev = head;
+    for (node* n = first; n != nullptr; n = n->get_next()) {
+      n->set_prev(prev);
+      prev->set_next(n);
+      prev = n;
+    }
+    prev->set_next(tail);
+    tail->set_prev(prev);
   }
 
-  iterator begin() { return iterator{head_.get_next()}; }
-  const_iterator begin() const { return const_iterator{head_.get_next()}; }
+  void sort() {
+    sort([](const T& a, const T& b) { return a < b; });
+  }
+
+  // Merges the sorted list `other` into this sorted list, leaving `other` empty. Stable: on ties
+  // elements of this list come first. Runs of `other` are moved with a single splice each.
+  template <typename Compare>
+  void merge(basic_intrusive_list& other, Compare comp) {
+    if (&other == this) {
+      return;
+    }
+    iterator it = begin();
+    while (it != end() && !other.empty()) {
+      if (!comp(other.front(), *it)) {
+        ++it;
+        continue;
+      }
+      iterator run_end = other.begin();
+      size_type n = 0;
+      do {
+        ++run_end;
+        ++n;
+      } while (run_end != other.end() && comp(*run_end, *it));
+      transfer_after(*node_before(it), *other.before_begin_node()->get_next(),
+                     *other.node_before(run_end));
+      size_add(n);
+      other.size_sub(n);
+    }
+    splice(end(), other);
+  }
+
+  void merge(basic_intrusive_list& other) {
+    merge(other, [](const T& a, const T& b) { return a < b; });
+  }
+
+  // Detaches every element after `it` into a new list. O(1), or O(n) for counted lists.
+  [[nodiscard]] basic_intrusive_list split_after(const_iterator it) {
+    assert(it != end() && "can't split after end().");
+    basic_intrusive_list tail;
+    tail.splice(tail.end(), *this, ++it, end());
+    return tail;
+  }
+
+  iterator begin() { return iterator{before_begin_node()->get_next()}; }
+  const_iterator begin() const { return const_iterator{before_begin_node()->get_next()}; }
   const_iterator cbegin() const { return begin(); }
-  iterator end() { return iterator{&tail_}; }
-  const_iterator end() const { return const_iterator{&tail_}; }
+  iterator end() { return iterator{end_node()}; }
+  const_iterator end() const { return const_iterator{end_node()}; }
   const_iterator cend() const { return end(); }
+
+private:
+  // a normal mode node keeps stale links once erased, which the debug checks in insert_after
+  // would take for a node that is still linked.
+  void link_after(node& pos, node& n) {
+#ifndef NDEBUG
+    if constexpr (mode == link_mode::normal) {
+      n.set_next(nullptr);
+      n.set_prev(nullptr);
+    }
+#endif
+    insert_after(pos, n);
+  }
+
+  static reference element(reference val) { return val; }
+  static reference element(pointer val) { return *val; }
+
+  template <typename InputIt>
+  void link_range_after(node& pos, InputIt first, InputIt last) {
+    modification_invariant();
+    node* head = nullptr;
+    node* tail = nullptr;
+    size_type n = 0;
+    for (; first != last; ++first) {
+      node& cur = Hook::node_of(element(*first));
+      assert((mode == link_mode::normal || !cur.is_linked()) &&
+             "this node is already part of a list.");
+      if (tail != nullptr) {
+        tail->set_next(&cur);
+        cur.set_prev(tail);
+      } else {
+        head = &cur;
+      }
+      tail = &cur;
+      ++n;
+    }
+    if (head == nullptr) {
+      return;
+    }
+    node* next = pos.get_next();
+    head->set_prev(&pos);
+    tail->set_next(next);
+    pos.set_next(head);
+    next->set_prev(tail);
+    size_add(n);
+  }
+
+  void unlink(node* n) {
+    if constexpr (mode == link_mode::normal) {
+      base::bypass(n);
+      size_sub(1);
+    } else {
+      erase(n);
+    }
+  }
+
+  // the node `pos` would be inserted after. Valid for end().
+  node* node_before(const_iterator pos) {
+    return const_cast<node*>(pos.ptr_)->get_prev();
+  }
 };
+
+// List linked through the `node_ptr` member of T, an intrusive_node or another
+// basic_intrusive_node.
+template <typename T, auto node_ptr, typename... Options>
+using intrusive_list = basic_intrusive_list<T, details::member_hook_for<T, node_ptr>, Options...>;
+
+// List linked through T's intrusive_base_node<Tag> base.
+template <typename T, typename Tag = void, typename... Options>
+using intrusive_base_list = basic_intrusive_list<T, base_hook<T, Tag>, Options...>;
+
+// Calls `fn` on every element of `list` in order, like a range-for, while a second cursor runs
+// `distance` elements ahead prefetching the next hook and, for a non-negative `payload_offset`,
+// the byte at that offset in its element. Each step of the look-ahead cursor is still a dependent
+// load, so this pays off when the list's elements are scattered and `fn` touches enough of each
+// one for those misses to overlap with its work.
+template <typename List, typename F>
+void for_each_prefetch(List& list, F fn, std::size_t distance = 8,
+                       std::ptrdiff_t payload_offset = -1) {
+  auto it = list.begin();
+  auto end = list.end();
+  auto ahead = it;
+  auto advance_ahead = [&] {
+    details::prefetch(ahead.ptr_->get_next());
+    if (payload_offset >= 0) {
+      details::prefetch(reinterpret_cast<const char*>(&*ahead) + payload_offset);
+    }
+    ++ahead;
+  };
+  for (std::size_t i = 0; i != distance && ahead != end; ++i) {
+    advance_ahead();
+  }
+  while (it != end) {
+    if (ahead != end) {
+      advance_ahead();
+    }
+    fn(*it);
+    ++it;
+  }
+}
 } // namespace pep
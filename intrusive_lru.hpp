@@ -0,0 +1,278 @@
+/*
+ * intrusive_lru.hpp Copyright © 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#pragma once
+#include "intrusive_hash_table.hpp"
+#include "intrusive_list.hpp"
+#include <mutex>
+
+namespace pep {
+
+struct intrusive_lru_node;
+template <typename T, intrusive_lru_node T::*node_ptr, typename KeyOf, typename Hash,
+          typename KeyEqual>
+class intrusive_lru;
+
+// Hook for intrusive_lru: a recency list link plus a hash index link. The hash link doesn't unlink
+// itself, an element must be erased or evicted before it is destroyed.
+struct intrusive_lru_node {
+private:
+  template <typename T, intrusive_lru_node T::*node_ptr, typename KeyOf, typename Hash,
+            typename KeyEqual>
+  friend class intrusive_lru;
+  intrusive_node list_;
+  intrusive_hash_node hash_;
+
+public:
+  constexpr intrusive_lru_node() noexcept = default;
+  intrusive_lru_node(const intrusive_lru_node&) = delete;
+  intrusive_lru_node& operator=(const intrusive_lru_node&) = delete;
+
+  template <typename T, intrusive_lru_node T::*mem_p>
+  const T* owner() const {
+    return details::owner_of<T, intrusive_lru_node, mem_p>(this);
+  }
+
+  template <typename T, intrusive_lru_node T::*mem_p>
+  T* owner() {
+    return const_cast<T*>(const_cast<const intrusive_lru_node*>(this)->owner<T, mem_p>());
+  }
+};
+
+// Least recently used index over elements keyed by `KeyOf` (see intrusive_hash_table). Elements
+// sit in a recency list, oldest first, and an intrusive hash index; lookups, touches and evictions
+// are O(1) and only relink, the cache never owns or allocates elements beyond its bucket array.
+// Evicted elements are handed to a disposer.
+template <typename T, intrusive_lru_node T::*node_ptr, typename KeyOf,
+          typename Hash = std::hash<details::key_of_t<T, KeyOf>>,
+          typename KeyEqual = std::equal_to<details::key_of_t<T, KeyOf>>>
+class intrusive_lru {
+  struct node_key {
+    KeyOf key_of;
+    decltype(auto) operator()(const intrusive_lru_node& n) const {
+      return key_of(*n.template owner<T, node_ptr>());
+    }
+  };
+  using list_type = intrusive_list<intrusive_lru_node, &intrusive_lru_node::list_,
+                                   constant_time_size<false>, circular_layout>;
+  using table_type = intrusive_hash_table<intrusive_lru_node, &intrusive_lru_node::hash_, node_key,
+                                          Hash, KeyEqual>;
+
+public:
+  using key_type = details::key_of_t<T, KeyOf>;
+  using value_type = T;
+  using reference = value_type&;
+  using pointer = value_type*;
+  using size_type = std::size_t;
+
+  explicit intrusive_lru(KeyOf key_of = KeyOf{}, Hash hash = Hash{}, KeyEqual equal = KeyEqual{})
+      : table_(node_key{std::move(key_of)}, std::move(hash), std::move(equal)) {}
+
+  intrusive_lru(const intrusive_lru&) = delete;
+  intrusive_lru& operator=(const intrusive_lru&) = delete;
+
+  ~intrusive_lru() { clear(); }
+
+  [[nodiscard]] bool empty() const { return table_.empty(); }
+  [[nodiscard]] size_type size() const { return table_.size(); }
+
+  size_type hash(const key_type& key) const { return table_.hash(key); }
+
+  // Links `val` as the most recently used element, unless an element with an equal key is already
+  // cached. Returns whether `val` was linked.
+  bool insert(reference val) { return insert(val, hash(table_.key_of()(val.*node_ptr))); }
+
+  bool insert(reference val, size_type h) {
+    intrusive_lru_node& n = val.*node_ptr;
+    if (!table_.insert(n, h)) {
+      return false;
+    }
+    list_.push_back(n);
+    return true;
+  }
+
+  // Looks `key` up without touching it.
+  pointer find(const key_type& key) { return find(key, hash(key)); }
+
+  pointer find(const key_type& key, size_type h) { return owner(table_.find(key, h)); }
+
+  // Looks `key` up and marks it most recently used.
+  pointer get(const key_type& key) { return get(key, hash(key)); }
+
+  pointer get(const key_type& key, size_type h) {
+    intrusive_lru_node* n = table_.find(key, h);
+    if (n != nullptr) {
+      list_.move_to_back(*n);
+    }
+    return owner(n);
+  }
+
+  // Marks the cached `val` most recently used.
+  void touch(reference val) { list_.move_to_back(val.*node_ptr); }
+
+  // least recently used element, the next to be evicted.
+  reference oldest() { return *owner(&list_.front()); }
+  reference newest() { return *owner(&list_.back()); }
+
+  // Unlinks the cached `val`.
+  void erase(reference val) {
+    intrusive_lru_node& n = val.*node_ptr;
+    table_.erase(n);
+    list_.erase(n);
+  }
+
+  // Unlinks and returns the element with a key equal to `key`, or returns null.
+  pointer erase(const key_type& key) { return erase(key, hash(key)); }
+
+  pointer erase(const key_type& key, size_type h) {
+    intrusive_lru_node* n = table_.erase(key, h);
+    if (n != nullptr) {
+      list_.erase(*n);
+    }
+    return owner(n);
+  }
+
+  // Unlinks the least recently used element and passes it to `dispose(T&)`. Returns false if the
+  // cache was empty.
+  template <typename Disposer>
+  bool evict(Disposer&& dispose) {
+    if (list_.empty()) {
+      return false;
+    }
+    intrusive_lru_node& n = list_.front();
+    list_.pop_front();
+    table_.erase(n);
+    dispose(*owner(&n));
+    return true;
+  }
+
+  // Evicts least recently used elements until at most `n` remain.
+  template <typename Disposer>
+  void evict_to(size_type n, Disposer&& dispose) {
+    while (size() > n) {
+      evict(dispose);
+    }
+  }
+
+  // Unlinks every element without disposing of them.
+  void clear() {
+    list_.clear();
+    table_.clear();
+  }
+
+private:
+  static pointer owner(intrusive_lru_node* n) {
+    return n != nullptr ? n->template owner<T, node_ptr>() : nullptr;
+  }
+
+  list_type list_;
+  table_type table_;
+};
+
+// `Shards` independent intrusive_lru instances, each behind its own mutex on its own cache line.
+// An element belongs to the shard picked by its key's hash, so threads working on different keys
+// rarely contend. Capacity is enforced per shard: inserting into a full shard evicts that shard's
+// least recently used element, which is not necessarily the globally oldest one.
+template <typename T, intrusive_lru_node T::*node_ptr, typename KeyOf, std::size_t Shards,
+          typename Hash = std::hash<details::key_of_t<T, KeyOf>>,
+          typename KeyEqual = std::equal_to<details::key_of_t<T, KeyOf>>>
+class intrusive_sharded_lru {
+  using lru_type = intrusive_lru<T, node_ptr, KeyOf, Hash, KeyEqual>;
+  static_assert(Shards > 0, "need at least one shard.");
+
+public:
+  using key_type = typename lru_type::key_type;
+  using value_type = T;
+  using reference = value_type&;
+  using pointer = value_type*;
+  using size_type = std::size_t;
+
+  // `capacity` is split evenly across the shards, rounding up.
+  explicit intrusive_sharded_lru(size_type capacity)
+      : shard_capacity_((capacity + Shards - 1) / Shards) {}
+
+  intrusive_sharded_lru(const intrusive_sharded_lru&) = delete;
+  intrusive_sharded_lru& operator=(const intrusive_sharded_lru&) = delete;
+
+  static constexpr size_type shard_count() { return Shards; }
+  size_type shard_capacity() const { return shard_capacity_; }
+
+  // Links `val` as its shard's most recently used element, then evicts from that shard down to its
+  // capacity, passing each evicted element to `dispose(T&)` with the shard locked. Returns false,
+  // without evicting, if an element with an equal key is already cached.
+  template <typename Disposer>
+  bool insert(reference val, Disposer&& dispose) {
+    size_type h = hash_(key_of_(val));
+    shard& s = shard_for(h);
+    std::lock_guard<std::mutex> guard{s.lock};
+    if (!s.lru.insert(val, h)) {
+      return false;
+    }
+    s.lru.evict_to(shard_capacity_, dispose);
+    return true;
+  }
+
+  // Looks `key` up, marks it most recently used and calls `f(T&)` with the shard still locked.
+  // Returns whether `key` was found.
+  template <typename F>
+  bool visit(const key_type& key, F&& f) {
+    size_type h = hash_(key);
+    shard& s = shard_for(h);
+    std::lock_guard<std::mutex> guard{s.lock};
+    pointer p = s.lru.get(key, h);
+    if (p == nullptr) {
+      return false;
+    }
+    f(*p);
+    return true;
+  }
+
+  // Unlinks and returns the element with a key equal to `key`, or returns null. The element is the
+  // caller's once returned.
+  pointer erase(const key_type& key) {
+    size_type h = hash_(key);
+    shard& s = shard_for(h);
+    std::lock_guard<std::mutex> guard{s.lock};
+    return s.lru.erase(key, h);
+  }
+
+  // Evicts every element, shard by shard.
+  template <typename Disposer>
+  void clear(Disposer&& dispose) {
+    for (shard& s : shards_) {
+      std::lock_guard<std::mutex> guard{s.lock};
+      s.lru.evict_to(0, dispose);
+    }
+  }
+
+  // only a snapshot under concurrent use.
+  size_type size() {
+    size_type total = 0;
+    for (shard& s : shards_) {
+      std::lock_guard<std::mutex> guard{s.lock};
+      total += s.lru.size();
+    }
+    return total;
+  }
+
+private:
+  struct alignas(details::cache_line_size) shard {
+    std::mutex lock;
+    lru_type lru;
+  };
+
+  shard& shard_for(size_type h) {
+    // bucket indices mix every bit of the hash, so taking the low ones here doesn't leave buckets
+    // of a shard unused.
+    return shards_[h % Shards];
+  }
+
+  size_type shard_capacity_;
+  KeyOf key_of_;
+  Hash hash_;
+  shard shards_[Shards];
+};
+} // namespace pep
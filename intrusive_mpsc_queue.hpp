@@ -0,0 +1,138 @@
+/*
+ * intrusive_mpsc_queue.hpp Copyright © 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#pragma once
+#include "intrusive_list.hpp"
+#include <atomic>
+
+namespace pep {
+
+struct intrusive_mpsc_node;
+template <typename T, intrusive_mpsc_node T::*node_ptr>
+class intrusive_mpsc_queue;
+
+// Hook for intrusive_mpsc_queue, a single atomic next pointer. Nodes don't know whether they are
+// queued, so an element must be popped before it is destroyed.
+struct intrusive_mpsc_node {
+private:
+  template <typename T, intrusive_mpsc_node T::*node_ptr>
+  friend class intrusive_mpsc_queue;
+  std::atomic<intrusive_mpsc_node*> next_{nullptr};
+
+public:
+  constexpr intrusive_mpsc_node() noexcept = default;
+  intrusive_mpsc_node(const intrusive_mpsc_node&) = delete;
+  intrusive_mpsc_node& operator=(const intrusive_mpsc_node&) = delete;
+
+  // for building a chain to hand to push_chain(). Not synchronized, the chain must be private to
+  // the calling thread until it's published.
+  void set_next(intrusive_mpsc_node* n) {
+    assert(n != this && "attempted to link to self.");
+    next_.store(n, std::memory_order_relaxed);
+  }
+
+  template <typename T, intrusive_mpsc_node T::*mem_p>
+  const T* owner() const {
+    return details::owner_of<T, intrusive_mpsc_node, mem_p>(this);
+  }
+
+  template <typename T, intrusive_mpsc_node T::*mem_p>
+  T* owner() {
+    return const_cast<T*>(const_cast<const intrusive_mpsc_node*>(this)->owner<T, mem_p>());
+  }
+};
+
+// Multi-producer single-consumer queue after Dmitry Vyukov's intrusive MPSC node-based queue.
+// push() is wait-free: one atomic exchange plus one store. pop() is lock-free for the single
+// consumer, it may return null while a producer is between its exchange and its store, even though
+// the queue isn't empty; callers treat that like an empty queue and retry later. Nothing is ever
+// allocated, the queue holds one stub node of its own.
+template <typename T, intrusive_mpsc_node T::*node_ptr>
+class intrusive_mpsc_queue {
+public:
+  using value_type = T;
+  using reference = value_type&;
+  using pointer = value_type*;
+
+  intrusive_mpsc_queue() noexcept : head_(&stub_), tail_(&stub_) {}
+
+  intrusive_mpsc_queue(const intrusive_mpsc_queue&) = delete;
+  intrusive_mpsc_queue& operator=(const intrusive_mpsc_queue&) = delete;
+
+  // any thread.
+  void push(reference val) { push_nodes(val.*node_ptr, val.*node_ptr); }
+
+  // Publishes `first` .. `last`, already linked through intrusive_mpsc_node::set_next(), with a
+  // single atomic exchange. Any thread.
+  void push_chain(reference first, reference last) { push_nodes(first.*node_ptr, last.*node_ptr); }
+
+  // Links [first, last) locally and publishes it with push_chain(). `It` dereferences to T&. Any
+  // thread.
+  template <typename It>
+  void push_range(It first, It last) {
+    if (first == last) {
+      return;
+    }
+    reference head = *first;
+    intrusive_mpsc_node* prev = &(head.*node_ptr);
+    for (++first; first != last; ++first) {
+      intrusive_mpsc_node* n = &((*first).*node_ptr);
+      prev->set_next(n);
+      prev = n;
+    }
+    push_nodes(head.*node_ptr, *prev);
+  }
+
+  // Consumer only. Returns null if the queue is empty or a push is still in flight.
+  pointer pop() {
+    intrusive_mpsc_node* tail = tail_;
+    intrusive_mpsc_node* next = tail->next_.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (next == nullptr) {
+        return nullptr;
+      }
+      tail_ = next;
+      tail = next;
+      next = next->next_.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+      tail_ = next;
+      return tail->template owner<T, node_ptr>();
+    }
+    if (tail != head_.load(std::memory_order_acquire)) {
+      // a producer has swapped head_ but not linked its node yet.
+      return nullptr;
+    }
+    // `tail` is the last node; put the stub behind it so it can be handed out.
+    push_nodes(stub_, stub_);
+    next = tail->next_.load(std::memory_order_acquire);
+    if (next != nullptr) {
+      tail_ = next;
+      return tail->template owner<T, node_ptr>();
+    }
+    return nullptr;
+  }
+
+  // Consumer only. May report empty while a push is in flight.
+  [[nodiscard]] bool empty() const {
+    const intrusive_mpsc_node* tail = tail_;
+    return tail == &stub_ && tail->next_.load(std::memory_order_acquire) == nullptr;
+  }
+
+private:
+  void push_nodes(intrusive_mpsc_node& first, intrusive_mpsc_node& last) {
+    last.next_.store(nullptr, std::memory_order_relaxed);
+    intrusive_mpsc_node* prev = head_.exchange(&last, std::memory_order_acq_rel);
+    prev->next_.store(&first, std::memory_order_release);
+  }
+
+  // written by every producer.
+  alignas(details::cache_line_size) std::atomic<intrusive_mpsc_node*> head_;
+  // consumer only.
+  alignas(details::cache_line_size) intrusive_mpsc_node* tail_;
+  intrusive_mpsc_node stub_;
+};
+} // namespace pep
@@ -0,0 +1,422 @@
+/*
+ * intrusive_object_pool.hpp Copyright © 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#pragma once
+#include "intrusive_atomic_stack.hpp"
+#include "intrusive_slist.hpp"
+#include <algorithm>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace pep {
+
+namespace details {
+// A free block as the pool sees it: nothing but the link of its magazine.
+struct pool_block {
+  intrusive_slist_node node;
+};
+
+using block_list = intrusive_slist<pool_block, &pool_block::node, cache_last<true>>;
+
+// The header of a magazine handed to the depot. Headers are carved from the chunks like blocks
+// but are never handed out: they only move between the depot and the pool's spare headers, and
+// their link is only ever written atomically, because a pop on either stack may still read it
+// after another thread took the header.
+struct parked_magazine {
+  intrusive_stack_node depot_node;
+  block_list blocks;
+  std::size_t count = 0;
+};
+
+// Everything threads share: the geometry, the depot of full magazines, the headers not in use and
+// the chunks blocks are carved from. Thread caches hold a reference too, so it outlives the pool
+// until the last thread that used it lets go.
+struct pool_state {
+  std::size_t block_size;
+  std::size_t block_align;
+  std::size_t magazine_size;
+  std::atomic<bool> closed{false};
+  intrusive_atomic_stack<parked_magazine, &parked_magazine::depot_node> depot;
+  intrusive_atomic_stack<parked_magazine, &parked_magazine::depot_node> spare_headers;
+
+  std::mutex chunk_lock;
+  std::vector<char*> chunks;
+  char* bump = nullptr;
+  char* bump_end = nullptr;
+
+  pool_state(std::size_t size, std::size_t align, std::size_t magazine)
+      : block_size(size), block_align(align), magazine_size(magazine) {}
+
+  pool_state(const pool_state&) = delete;
+  pool_state& operator=(const pool_state&) = delete;
+
+  // parked magazines and every block live in the chunks, which simply go away.
+  ~pool_state() {
+    for (char* chunk : chunks) {
+      ::operator delete(chunk, std::align_val_t{block_align});
+    }
+  }
+
+  // hands out `count` fresh blocks, starting a new chunk of eight magazines when needed.
+  char* carve(std::size_t count) {
+    std::lock_guard<std::mutex> guard{chunk_lock};
+    std::size_t bytes = count * block_size;
+    if (static_cast<std::size_t>(bump_end - bump) < bytes) {
+      std::size_t chunk_bytes = std::max(bytes, 8 * magazine_size * block_size);
+      chunks.reserve(chunks.size() + 1);
+      bump = static_cast<char*>(::operator new(chunk_bytes, std::align_val_t{block_align}));
+      bump_end = bump + chunk_bytes;
+      chunks.push_back(bump);
+    }
+    char* first = bump;
+    bump += bytes;
+    return first;
+  }
+
+  // `count` fresh blocks plus one header for the spare stack, so that magazines carved fresh
+  // can be parked without allocating.
+  char* carve_magazine(std::size_t count) {
+    char* first = carve(count + 1);
+    spare_headers.push(*new (first + count * block_size) parked_magazine{});
+    return first;
+  }
+
+  // a spare header, or a freshly carved one. Null if none can be had.
+  parked_magazine* take_header() noexcept {
+    if (parked_magazine* m = spare_headers.pop()) {
+      return m;
+    }
+    try {
+      return new (carve(1)) parked_magazine{};
+    } catch (const std::bad_alloc&) {
+      return nullptr;
+    }
+  }
+
+  // moves the magazine `blocks` of `count` blocks to the depot. Should no header be had, the
+  // blocks stay stranded in their chunk until the pool goes away.
+  void park(block_list& blocks, std::size_t count) noexcept {
+    parked_magazine* m = take_header();
+    if (m == nullptr) {
+      blocks.clear();
+      return;
+    }
+    m->blocks = std::move(blocks);
+    m->count = count;
+    depot.push(*m);
+  }
+
+  // Uncached allocate and deallocate, for threads whose caches are already gone: a block from the
+  // depot or a fresh one, and a freed block parked as a magazine of its own.
+  void* take_one() {
+    parked_magazine* m = depot.pop();
+    if (m == nullptr) {
+      return carve(1);
+    }
+    pool_block& b = m->blocks.front();
+    m->blocks.pop_front();
+    b.~pool_block();
+    if (--m->count != 0) {
+      depot.push(*m);
+    } else {
+      spare_headers.push(*m);
+    }
+    return &b;
+  }
+
+  void give_one(void* p) noexcept {
+    block_list single;
+    single.push_front(*new (p) pool_block{});
+    park(single, 1);
+  }
+};
+
+// A thread's two magazines for one pool, after Bonwick's magazine layer: allocations pop from
+// `loaded`; when it runs dry a full `previous` is swapped in before the depot is tried, and when
+// both are full on a free one of them is parked. A thread that alternates between allocating and
+// freeing around a magazine boundary therefore doesn't go to the depot every time.
+struct pool_thread_cache {
+  std::shared_ptr<pool_state> state;
+  block_list loaded;
+  block_list previous;
+  std::size_t loaded_count = 0;
+  std::size_t previous_count = 0;
+
+  explicit pool_thread_cache(std::shared_ptr<pool_state> s) : state(std::move(s)) {}
+
+  pool_thread_cache(const pool_thread_cache&) = delete;
+  pool_thread_cache& operator=(const pool_thread_cache&) = delete;
+
+  // hands partial magazines back, the blocks may have been allocated on another thread.
+  ~pool_thread_cache() {
+    park(loaded, loaded_count);
+    park(previous, previous_count);
+  }
+
+  void* allocate() {
+    if (loaded_count == 0) {
+      if (previous_count != 0) {
+        swap_magazines();
+      } else if (!unpark()) {
+        refill();
+      }
+    }
+    pool_block& b = loaded.front();
+    loaded.pop_front();
+    --loaded_count;
+    b.~pool_block();
+    return &b;
+  }
+
+  void deallocate(void* p) {
+    if (loaded_count == state->magazine_size) {
+      if (previous_count == state->magazine_size) {
+        park(previous, previous_count);
+      }
+      swap_magazines();
+    }
+    loaded.push_front(*new (p) pool_block{});
+    ++loaded_count;
+  }
+
+  void swap_magazines() {
+    block_list tmp{std::move(loaded)};
+    loaded = std::move(previous);
+    previous = std::move(tmp);
+    std::swap(loaded_count, previous_count);
+  }
+
+  // moves a magazine to the depot.
+  void park(block_list& blocks, std::size_t& count) noexcept {
+    if (count == 0) {
+      return;
+    }
+    state->park(blocks, count);
+    count = 0;
+  }
+
+  // loads a magazine from the depot, false if there is none. Its header goes back to the spares.
+  bool unpark() {
+    parked_magazine* m = state->depot.pop();
+    if (m == nullptr) {
+      return false;
+    }
+    loaded = std::move(m->blocks);
+    loaded_count = m->count;
+    state->spare_headers.push(*m);
+    return true;
+  }
+
+  // loads a magazine of fresh blocks.
+  void refill() {
+    std::size_t count = state->magazine_size;
+    char* first = state->carve_magazine(count);
+    for (std::size_t i = count; i-- != 0;) {
+      loaded.push_front(*new (first + i * state->block_size) pool_block{});
+    }
+    loaded_count = count;
+  }
+};
+
+// Set once the thread's caches are destroyed. Thread-local objects go before objects with static
+// storage duration and in reverse order of construction, so a pool can still be used after that.
+// Being trivially destructible, the flag stays readable until the thread ends.
+inline thread_local bool pool_caches_gone = false;
+
+// The calling thread's caches, one per pool it has used. Looking up the pool used last is a
+// single comparison; caches of pools that have since been destroyed are dropped on the next miss.
+struct pool_thread_caches {
+  std::vector<std::unique_ptr<pool_thread_cache>> caches;
+  pool_thread_cache* last = nullptr;
+
+  pool_thread_caches() = default;
+  pool_thread_caches(const pool_thread_caches&) = delete;
+  pool_thread_caches& operator=(const pool_thread_caches&) = delete;
+
+  // parks every magazine as the caches go; from here on the thread bypasses them.
+  ~pool_thread_caches() { pool_caches_gone = true; }
+
+  pool_thread_cache& get(const std::shared_ptr<pool_state>& state) {
+    if (last != nullptr && last->state == state) {
+      return *last;
+    }
+    return find_or_add(state);
+  }
+
+  pool_thread_cache& find_or_add(const std::shared_ptr<pool_state>& state) {
+    caches.erase(std::remove_if(caches.begin(), caches.end(),
+                                [](const std::unique_ptr<pool_thread_cache>& c) {
+                                  return c->state->closed.load(std::memory_order_relaxed);
+                                }),
+                 caches.end());
+    auto it = std::find_if(caches.begin(), caches.end(),
+                           [&](const std::unique_ptr<pool_thread_cache>& c) {
+                             return c->state == state;
+                           });
+    if (it == caches.end()) {
+      caches.push_back(std::make_unique<pool_thread_cache>(state));
+      it = caches.end() - 1;
+    }
+    last = it->get();
+    return *last;
+  }
+
+  // forgets the cache of a pool being destroyed, if this thread has one.
+  void drop(const pool_state* state) {
+    last = nullptr;
+    caches.erase(std::remove_if(caches.begin(), caches.end(),
+                                [&](const std::unique_ptr<pool_thread_cache>& c) {
+                                  return c->state.get() == state;
+                                }),
+                 caches.end());
+  }
+};
+
+inline thread_local pool_thread_caches pool_caches;
+} // namespace details
+
+// Fixed-size block allocator with per-thread caches. Free blocks are linked through an
+// intrusive_slist hook stored in the blocks themselves, so free memory costs nothing to track.
+//   - Each thread keeps two magazines of up to `magazine_size` free blocks. allocate() and
+//     deallocate() stay thread-local and lock-free while the thread's magazines have room.
+//   - Full magazines go to a global depot, an intrusive_atomic_stack, and are taken back from it
+//     whole, so a block freed on another thread than the one that allocated it returns through
+//     the depot. A parked magazine is described by a header block that is never handed out.
+//   - When the depot is empty a magazine of fresh blocks, and a header for it, is carved from a
+//     chunk under a mutex.
+// Memory is only returned when the pool is destroyed and every thread that used it has exited or
+// used another pool since; blocks still allocated at that point are released with it. Blocks are
+// at least four words.
+class intrusive_block_pool {
+public:
+  explicit intrusive_block_pool(std::size_t block_size,
+                                std::size_t block_align = alignof(std::max_align_t),
+                                std::size_t magazine_size = 64)
+      : state_(std::make_shared<details::pool_state>(
+          round_up(std::max(block_size, sizeof(details::parked_magazine)),
+                   std::max(block_align, alignof(details::parked_magazine))),
+          std::max(block_align, alignof(details::parked_magazine)),
+          std::max<std::size_t>(magazine_size, 1))) {}
+
+  intrusive_block_pool(const intrusive_block_pool&) = delete;
+  intrusive_block_pool& operator=(const intrusive_block_pool&) = delete;
+
+  ~intrusive_block_pool() {
+    state_->closed.store(true, std::memory_order_relaxed);
+    if (!details::pool_caches_gone) {
+      details::pool_caches.drop(state_.get());
+    }
+  }
+
+  [[nodiscard]] std::size_t block_size() const { return state_->block_size; }
+  [[nodiscard]] std::size_t block_align() const { return state_->block_align; }
+  [[nodiscard]] std::size_t magazine_size() const { return state_->magazine_size; }
+
+  // Uninitialised storage for one block. Throws std::bad_alloc if a new chunk can't be allocated.
+  // Threads whose caches are already gone, during their exit or the program's, go straight to the
+  // depot or the chunk mutex instead.
+  [[nodiscard]] void* allocate() {
+    if (details::pool_caches_gone) {
+      return state_->take_one();
+    }
+    return details::pool_caches.get(state_).allocate();
+  }
+
+  // `p` must come from allocate() on this pool, from any thread.
+  void deallocate(void* p) {
+    assert(p != nullptr);
+    if (details::pool_caches_gone) {
+      state_->give_one(p);
+      return;
+    }
+    details::pool_caches.get(state_).deallocate(p);
+  }
+
+private:
+  static std::size_t round_up(std::size_t n, std::size_t align) {
+    return (n + align - 1) / align * align;
+  }
+
+  std::shared_ptr<details::pool_state> state_;
+};
+
+// intrusive_block_pool sized and aligned for T.
+template <typename T>
+class intrusive_object_pool {
+public:
+  explicit intrusive_object_pool(std::size_t magazine_size = 64)
+      : pool_(sizeof(T), alignof(T), magazine_size) {}
+
+  // Uninitialised storage for one T.
+  [[nodiscard]] T* allocate() { return static_cast<T*>(pool_.allocate()); }
+  void deallocate(T* p) { pool_.deallocate(p); }
+
+  template <typename... Args>
+  [[nodiscard]] T* create(Args&&... args) {
+    void* p = pool_.allocate();
+    try {
+      return new (p) T(std::forward<Args>(args)...);
+    } catch (...) {
+      pool_.deallocate(p);
+      throw;
+    }
+  }
+
+  void destroy(T* p) {
+    p->~T();
+    pool_.deallocate(p);
+  }
+
+  intrusive_block_pool& blocks() { return pool_; }
+
+private:
+  intrusive_block_pool pool_;
+};
+
+// std::pmr::memory_resource over an intrusive_block_pool, for std::pmr containers whose
+// allocations are mostly of one size, node based ones in particular. Requests the pool's blocks
+// can hold are served from it, anything bigger or more aligned goes to `upstream`.
+class pool_memory_resource : public std::pmr::memory_resource {
+public:
+  explicit pool_memory_resource(intrusive_block_pool& pool,
+                                std::pmr::memory_resource* upstream =
+                                  std::pmr::get_default_resource())
+      : pool_(pool), upstream_(upstream) {}
+
+  intrusive_block_pool& pool() const { return pool_; }
+  std::pmr::memory_resource* upstream_resource() const { return upstream_; }
+
+private:
+  bool fits(std::size_t bytes, std::size_t alignment) const {
+    return bytes <= pool_.block_size() && alignment <= pool_.block_align();
+  }
+
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    if (fits(bytes, alignment)) {
+      return pool_.allocate();
+    }
+    return upstream_->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+    if (fits(bytes, alignment)) {
+      pool_.deallocate(p);
+    } else {
+      upstream_->deallocate(p, bytes, alignment);
+    }
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+
+  intrusive_block_pool& pool_;
+  std::pmr::memory_resource* upstream_;
+};
+} // namespace pep
@@ -0,0 +1,263 @@
+/*
+ * intrusive_pairing_heap.hpp Copyright © 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#pragma once
+#include "intrusive_list.hpp"
+#include <functional>
+
+namespace pep {
+
+struct intrusive_heap_node;
+template <typename T, intrusive_heap_node T::*node_ptr, typename Compare>
+class intrusive_pairing_heap;
+
+// Hook for intrusive_pairing_heap, three pointers: the first child, the next sibling, and the
+// previous sibling, or the parent for a first child. The root points back at itself. Nodes don't
+// unlink themselves, an element must be erased before it is destroyed.
+struct intrusive_heap_node {
+private:
+  template <typename T, intrusive_heap_node T::*node_ptr, typename Compare>
+  friend class intrusive_pairing_heap;
+  intrusive_heap_node* child_{nullptr};
+  intrusive_heap_node* next_{nullptr};
+  intrusive_heap_node* prev_{nullptr};
+
+public:
+  constexpr intrusive_heap_node() noexcept = default;
+  intrusive_heap_node(const intrusive_heap_node&) = delete;
+  intrusive_heap_node& operator=(const intrusive_heap_node&) = delete;
+
+  bool is_linked() const { return prev_ != nullptr; }
+
+  template <typename T, intrusive_heap_node T::*mem_p>
+  const T* owner() const {
+    return details::owner_of<T, intrusive_heap_node, mem_p>(this);
+  }
+
+  template <typename T, intrusive_heap_node T::*mem_p>
+  T* owner() {
+    return const_cast<T*>(const_cast<const intrusive_heap_node*>(this)->owner<T, mem_p>());
+  }
+};
+
+// Pairing heap over elements linked through an intrusive_heap_node in T. top() is the smallest
+// element by `Compare`, as with std::priority_queue<T, C, std::greater<T>>.
+//   - push() and merge() are O(1): one comparison and a relink.
+//   - pop() and erase() are amortised O(log n): the removed node's children are paired off left
+//     to right and the pairs melded right to left.
+//   - decrease() restores the heap after an element's key got smaller. It cuts the element's
+//     subtree loose and melds it with the root: O(1) relinks, amortised O(log n) at worst.
+// Nothing is allocated.
+template <typename T, intrusive_heap_node T::*node_ptr, typename Compare = std::less<T>>
+class intrusive_pairing_heap {
+  using node = intrusive_heap_node;
+
+public:
+  using value_type = T;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using size_type = std::size_t;
+
+  explicit intrusive_pairing_heap(Compare comp = Compare{}) : comp_(std::move(comp)) {}
+
+  intrusive_pairing_heap(const intrusive_pairing_heap&) = delete;
+  intrusive_pairing_heap& operator=(const intrusive_pairing_heap&) = delete;
+
+  intrusive_pairing_heap(intrusive_pairing_heap&& other) noexcept
+      : comp_(std::move(other.comp_)), root_(other.root_), size_(other.size_) {
+    other.root_ = nullptr;
+    other.size_ = 0;
+  }
+
+  intrusive_pairing_heap& operator=(intrusive_pairing_heap&& other) noexcept {
+    if (&other != this) {
+      clear();
+      comp_ = std::move(other.comp_);
+      root_ = other.root_;
+      size_ = other.size_;
+      other.root_ = nullptr;
+      other.size_ = 0;
+    }
+    return *this;
+  }
+
+  ~intrusive_pairing_heap() { clear(); }
+
+  [[nodiscard]] bool empty() const { return root_ == nullptr; }
+  [[nodiscard]] size_type size() const { return size_; }
+
+  reference top() {
+    assert(!empty() && "top() called on empty heap.");
+    return *root_->template owner<T, node_ptr>();
+  }
+
+  const_reference top() const {
+    assert(!empty() && "top() called on empty heap.");
+    return *root_->template owner<T, node_ptr>();
+  }
+
+  void push(reference val) {
+    node& n = val.*node_ptr;
+    assert(!n.is_linked() && "pushing an element that is already in a heap.");
+    set_root(meld(root_, &n));
+    ++size_;
+  }
+
+  // Unlinks top().
+  void pop() {
+    assert(!empty() && "pop() called on empty heap.");
+    node* old = root_;
+    set_root(merge_pairs(old->child_));
+    reset(*old);
+    --size_;
+  }
+
+  // Restores the heap after the key of linked element `val` decreased.
+  void decrease(reference val) {
+    node& n = val.*node_ptr;
+    assert(n.is_linked() && "decrease() on an element that is not in a heap.");
+    if (&n == root_) {
+      return;
+    }
+    cut(n);
+    set_root(meld(root_, &n));
+  }
+
+  // Unlinks the linked element `val`.
+  void erase(reference val) {
+    node& n = val.*node_ptr;
+    assert(n.is_linked() && "erasing an element that is not in a heap.");
+    if (&n == root_) {
+      pop();
+      return;
+    }
+    cut(n);
+    set_root(meld(root_, merge_pairs(n.child_)));
+    reset(n);
+    --size_;
+  }
+
+  // Moves every element of `other` into this heap. O(1).
+  void merge(intrusive_pairing_heap& other) {
+    if (&other == this || other.empty()) {
+      return;
+    }
+    set_root(meld(root_, other.root_));
+    size_ += other.size_;
+    other.root_ = nullptr;
+    other.size_ = 0;
+  }
+
+  // Unlinks every element. O(n), the tree is walked with a stack threaded through the nodes.
+  void clear() {
+    if (root_ == nullptr) {
+      return;
+    }
+    node* stack = root_;
+    root_->prev_ = nullptr;
+    while (stack != nullptr) {
+      node* n = stack;
+      stack = n->prev_;
+      if (n->child_ != nullptr) {
+        n->child_->prev_ = stack;
+        stack = n->child_;
+      }
+      if (n->next_ != nullptr) {
+        n->next_->prev_ = stack;
+        stack = n->next_;
+      }
+      reset(*n);
+    }
+    root_ = nullptr;
+    size_ = 0;
+  }
+
+private:
+  static void reset(node& n) { n.child_ = n.next_ = n.prev_ = nullptr; }
+
+  void set_root(node* n) {
+    root_ = n;
+    if (n != nullptr) {
+      n->prev_ = n;
+    }
+  }
+
+  bool less(node* a, node* b) const {
+    return comp_(*a->template owner<T, node_ptr>(), *b->template owner<T, node_ptr>());
+  }
+
+  // links two sibling-less trees, the larger root becoming the first child of the smaller. The
+  // result's next_ is null and its prev_ unspecified.
+  node* meld(node* a, node* b) const {
+    if (a == nullptr) {
+      return b;
+    }
+    if (b == nullptr) {
+      return a;
+    }
+    if (less(b, a)) {
+      std::swap(a, b);
+    }
+    b->next_ = a->child_;
+    if (a->child_ != nullptr) {
+      a->child_->prev_ = b;
+    }
+    b->prev_ = a;
+    a->child_ = b;
+    return a;
+  }
+
+  // detaches the subtree rooted at non-root `n` from its parent and siblings.
+  static void cut(node& n) {
+    if (n.prev_->child_ == &n) {
+      n.prev_->child_ = n.next_;
+    } else {
+      n.prev_->next_ = n.next_;
+    }
+    if (n.next_ != nullptr) {
+      n.next_->prev_ = n.prev_;
+    }
+    n.next_ = nullptr;
+  }
+
+  // melds the sibling list starting at `first` into one tree: pairs left to right, chaining the
+  // results backwards through next_, then melds that chain from the last pair to the first.
+  node* merge_pairs(node* first) const {
+    if (first == nullptr) {
+      return nullptr;
+    }
+    node* pairs = nullptr;
+    while (first != nullptr) {
+      node* a = first;
+      node* b = a->next_;
+      if (b == nullptr) {
+        a->next_ = pairs;
+        pairs = a;
+        break;
+      }
+      first = b->next_;
+      a->next_ = b->next_ = nullptr;
+      node* m = meld(a, b);
+      m->next_ = pairs;
+      pairs = m;
+    }
+    node* result = pairs;
+    pairs = pairs->next_;
+    result->next_ = nullptr;
+    while (pairs != nullptr) {
+      node* n = pairs;
+      pairs = n->next_;
+      n->next_ = nullptr;
+      result = meld(result, n);
+    }
+    return result;
+  }
+
+  Compare comp_;
+  node* root_{nullptr};
+  size_type size_{0};
+};
+} // namespace pep
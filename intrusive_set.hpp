@@ -0,0 +1,776 @@
+/*
+ * intrusive_set.hpp Copyright © 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#pragma once
+#include "intrusive_list.hpp"
+#include <functional>
+
+namespace pep {
+
+struct intrusive_rbtree_node;
+namespace details {
+class rbtree_base;
+} // namespace details
+
+// Hook for intrusive_set. Three words: the parent pointer with the node's colour in its low bit,
+// and the two children. Like intrusive_node, a linked node unlinks itself when destroyed; that
+// walks up to the tree's header first, so it costs O(log n).
+struct intrusive_rbtree_node {
+private:
+  friend details::rbtree_base;
+
+  static constexpr std::uintptr_t red_bit = 1;
+  // set on the header node owned by the set, whose parent is the root.
+  static constexpr std::uintptr_t header_bit = 2;
+  static constexpr std::uintptr_t flag_bits = red_bit | header_bit;
+
+  std::uintptr_t parent_{0};
+  intrusive_rbtree_node* left_{nullptr};
+  intrusive_rbtree_node* right_{nullptr};
+
+  intrusive_rbtree_node* parent() const {
+    return reinterpret_cast<intrusive_rbtree_node*>(parent_ & ~flag_bits);
+  }
+  void set_parent(intrusive_rbtree_node* p) {
+    parent_ = reinterpret_cast<std::uintptr_t>(p) | (parent_ & flag_bits);
+  }
+  bool is_red() const { return (parent_ & red_bit) != 0; }
+  void set_red(bool red) { parent_ = red ? parent_ | red_bit : parent_ & ~red_bit; }
+  bool is_header() const { return (parent_ & header_bit) != 0; }
+
+  // takes over the tree position of `other`.
+  inline void replace(intrusive_rbtree_node& other);
+
+public:
+  constexpr intrusive_rbtree_node() noexcept = default;
+  intrusive_rbtree_node(const intrusive_rbtree_node&) = delete;
+  intrusive_rbtree_node& operator=(const intrusive_rbtree_node&) = delete;
+
+  intrusive_rbtree_node(intrusive_rbtree_node&& other) noexcept { replace(other); }
+
+  intrusive_rbtree_node& operator=(intrusive_rbtree_node&& other) noexcept {
+    if (&other != this) {
+      unlink();
+      replace(other);
+    }
+    return *this;
+  }
+
+  ~intrusive_rbtree_node() { unlink(); }
+
+  // every linked node has a parent, the root's is the header.
+  bool is_linked() const { return parent() != nullptr; }
+
+  // Removes this node from whatever tree it is in. O(log n).
+  inline void unlink();
+
+  template <typename T, intrusive_rbtree_node T::*mem_p>
+  const T* owner() const {
+    return details::owner_of<T, intrusive_rbtree_node, mem_p>(this);
+  }
+
+  template <typename T, intrusive_rbtree_node T::*mem_p>
+  T* owner() {
+    return const_cast<T*>(const_cast<const intrusive_rbtree_node*>(this)->owner<T, mem_p>());
+  }
+};
+
+namespace details {
+// Red-black tree over intrusive_rbtree_node with a header node, after the classic libstdc++
+// layout: header.parent is the root and the root's parent the header, header.left and
+// header.right are the leftmost and rightmost nodes, or the header itself when empty. Nothing here
+// depends on T, the comparisons live in intrusive_set.
+class rbtree_base {
+public:
+  using node = intrusive_rbtree_node;
+  using difference_type = std::ptrdiff_t;
+  using size_type = std::size_t;
+
+  inline rbtree_base() noexcept;
+
+  rbtree_base(const rbtree_base&) = delete;
+  rbtree_base& operator=(const rbtree_base&) = delete;
+
+  inline rbtree_base(rbtree_base&& other) noexcept;
+  inline rbtree_base& operator=(rbtree_base&& other) noexcept;
+
+  inline ~rbtree_base();
+
+  [[nodiscard]] bool empty() const { return header_.parent_ == node::header_bit; }
+  // O(n).
+  [[nodiscard]] inline size_type size() const;
+  // Unlinks every element. O(n).
+  inline void clear();
+
+  static inline node* next(const node* n);
+  static inline node* prev(const node* n);
+
+protected:
+  node* root() const { return header_.parent(); }
+  node* leftmost() const { return header_.left_; }
+  node* rightmost() const { return header_.right_; }
+  static node* left_of(const node* n) { return n->left_; }
+  static node* right_of(const node* n) { return n->right_; }
+  node* end_node() { return &header_; }
+  const node* end_node() const { return &header_; }
+
+  // links the unlinked `n` as the left or right child of `parent`, which may be the header of an
+  // empty tree, and rebalances.
+  void insert_at(node& n, node* parent, bool left) { link_and_rebalance(header_, n, parent, left); }
+
+  void erase(node& n) { erase_and_rebalance(header_, n); }
+
+  // checks the red-black properties and the header links of the whole tree. O(n), debug only.
+  inline void tree_invariant() const;
+
+private:
+  friend intrusive_rbtree_node;
+
+  // black height of the subtree at `n`, checking it on the way.
+  static inline std::size_t black_height(const node* n);
+
+  inline void reset() noexcept;
+  inline void move_from(rbtree_base& other) noexcept;
+
+  static void set_root(node& header, node* root) { header.set_parent(root); }
+  static inline node* minimum(node* n);
+  static inline node* maximum(node* n);
+  static inline void rotate_left(node& header, node* x);
+  static inline void rotate_right(node& header, node* x);
+  static inline void link_and_rebalance(node& header, node& x, node* parent, bool left);
+  static inline void erase_and_rebalance(node& header, node& z);
+
+  node header_;
+};
+
+inline rbtree_base::rbtree_base() noexcept {
+  reset();
+}
+
+inline void rbtree_base::reset() noexcept {
+  header_.parent_ = node::header_bit;
+  header_.left_ = &header_;
+  header_.right_ = &header_;
+}
+
+inline void rbtree_base::move_from(rbtree_base& other) noexcept {
+  if (other.empty()) {
+    reset();
+    return;
+  }
+  header_.parent_ = other.header_.parent_;
+  header_.left_ = other.header_.left_;
+  header_.right_ = other.header_.right_;
+  root()->set_parent(&header_);
+  other.reset();
+}
+
+inline rbtree_base::rbtree_base(rbtree_base&& other) noexcept {
+  move_from(other);
+}
+
+inline rbtree_base& rbtree_base::operator=(rbtree_base&& other) noexcept {
+  if (&other != this) {
+    clear();
+    move_from(other);
+  }
+  return *this;
+}
+
+inline rbtree_base::~rbtree_base() {
+  clear();
+  // leave the header unlinked so its own destructor has nothing to do.
+  header_.parent_ = 0;
+  header_.left_ = nullptr;
+  header_.right_ = nullptr;
+}
+
+inline rbtree_base::size_type rbtree_base::size() const {
+  size_type count = 0;
+  for (const node* n = header_.left_; n != &header_; n = next(n)) {
+    ++count;
+  }
+  return count;
+}
+
+inline void rbtree_base::clear() {
+  // post-order walk that cuts each leaf off its parent, no recursion and no rebalancing.
+  node* n = root();
+  while (n != nullptr) {
+    if (n->left_ != nullptr) {
+      n = n->left_;
+    } else if (n->right_ != nullptr) {
+      n = n->right_;
+    } else {
+      node* p = n->parent();
+      n->parent_ = 0;
+      if (p == &header_) {
+        break;
+      }
+      (p->left_ == n ? p->left_ : p->right_) = nullptr;
+      n = p;
+    }
+  }
+  reset();
+}
+
+inline void rbtree_base::tree_invariant() const {
+#ifndef NDEBUG
+  assert(header_.is_header() && !header_.is_red());
+  const node* r = root();
+  if (r == nullptr) {
+    assert(header_.left_ == &header_ && header_.right_ == &header_);
+    return;
+  }
+  assert(r->parent() == &header_ && "sanity error");
+  assert(!r->is_red() && "the root must be black.");
+  assert(header_.left_ == minimum(const_cast<node*>(r)) && "sanity error");
+  assert(header_.right_ == maximum(const_cast<node*>(r)) && "sanity error");
+  black_height(r);
+#endif
+}
+
+inline std::size_t rbtree_base::black_height(const node* n) {
+  if (n == nullptr) {
+    return 1;
+  }
+  if (n->left_ != nullptr) {
+    assert(n->left_->parent() == n && "sanity error");
+  }
+  if (n->right_ != nullptr) {
+    assert(n->right_->parent() == n && "sanity error");
+  }
+  if (n->is_red()) {
+    assert((n->left_ == nullptr || !n->left_->is_red()) && "red node with a red child.");
+    assert((n->right_ == nullptr || !n->right_->is_red()) && "red node with a red child.");
+  }
+  std::size_t left = black_height(n->left_);
+  std::size_t right = black_height(n->right_);
+  assert(left == right && "unbalanced black height.");
+  static_cast<void>(right);
+  return left + (n->is_red() ? 0 : 1);
+}
+
+inline rbtree_base::node* rbtree_base::minimum(node* n) {
+  while (n->left_ != nullptr) {
+    n = n->left_;
+  }
+  return n;
+}
+
+inline rbtree_base::node* rbtree_base::maximum(node* n) {
+  while (n->right_ != nullptr) {
+    n = n->right_;
+  }
+  return n;
+}
+
+inline rbtree_base::node* rbtree_base::next(const node* n) {
+  if (n->right_ != nullptr) {
+    return minimum(n->right_);
+  }
+  node* x = const_cast<node*>(n);
+  node* y = x->parent();
+  while (x == y->right_) {
+    x = y;
+    y = y->parent();
+  }
+  // x reached the header from the root when the root is the rightmost node.
+  return x->right_ != y ? y : x;
+}
+
+inline rbtree_base::node* rbtree_base::prev(const node* n) {
+  node* x = const_cast<node*>(n);
+  if (x->is_header()) {
+    return x->right_;
+  }
+  if (x->left_ != nullptr) {
+    return maximum(x->left_);
+  }
+  node* y = x->parent();
+  while (x == y->left_) {
+    x = y;
+    y = y->parent();
+  }
+  return y;
+}
+
+inline void rbtree_base::rotate_left(node& header, node* x) {
+  node* y = x->right_;
+  x->right_ = y->left_;
+  if (y->left_ != nullptr) {
+    y->left_->set_parent(x);
+  }
+  node* p = x->parent();
+  y->set_parent(p);
+  if (p == &header) {
+    set_root(header, y);
+  } else if (x == p->left_) {
+    p->left_ = y;
+  } else {
+    p->right_ = y;
+  }
+  y->left_ = x;
+  x->set_parent(y);
+}
+
+inline void rbtree_base::rotate_right(node& header, node* x) {
+  node* y = x->left_;
+  x->left_ = y->right_;
+  if (y->right_ != nullptr) {
+    y->right_->set_parent(x);
+  }
+  node* p = x->parent();
+  y->set_parent(p);
+  if (p == &header) {
+    set_root(header, y);
+  } else if (x == p->right_) {
+    p->right_ = y;
+  } else {
+    p->left_ = y;
+  }
+  y->right_ = x;
+  x->set_parent(y);
+}
+
+inline void rbtree_base::link_and_rebalance(node& header, node& x, node* parent, bool left) {
+  assert(!x.is_linked() && "this node is already part of a tree.");
+  x.parent_ = 0;
+  x.set_parent(parent);
+  x.set_red(true);
+  x.left_ = nullptr;
+  x.right_ = nullptr;
+  if (parent == &header) {
+    set_root(header, &x);
+    header.left_ = &x;
+    header.right_ = &x;
+  } else if (left) {
+    parent->left_ = &x;
+    if (parent == header.left_) {
+      header.left_ = &x;
+    }
+  } else {
+    parent->right_ = &x;
+    if (parent == header.right_) {
+      header.right_ = &x;
+    }
+  }
+
+  node* n = &x;
+  while (n != header.parent() && n->parent()->is_red()) {
+    node* p = n->parent();
+    node* g = p->parent();
+    if (p == g->left_) {
+      node* uncle = g->right_;
+      if (uncle != nullptr && uncle->is_red()) {
+        p->set_red(false);
+        uncle->set_red(false);
+        g->set_red(true);
+        n = g;
+        continue;
+      }
+      if (n == p->right_) {
+        n = p;
+        rotate_left(header, n);
+        p = n->parent();
+      }
+      p->set_red(false);
+      g->set_red(true);
+      rotate_right(header, g);
+    } else {
+      node* uncle = g->left_;
+      if (uncle != nullptr && uncle->is_red()) {
+        p->set_red(false);
+        uncle->set_red(false);
+        g->set_red(true);
+        n = g;
+        continue;
+      }
+      if (n == p->left_) {
+        n = p;
+        rotate_right(header, n);
+        p = n->parent();
+      }
+      p->set_red(false);
+      g->set_red(true);
+      rotate_left(header, g);
+    }
+  }
+  header.parent()->set_red(false);
+}
+
+inline void rbtree_base::erase_and_rebalance(node& header, node& z) {
+  assert(z.is_linked() && !z.is_header() && "Invalid node.");
+  node* y = &z;
+  node* x = nullptr;
+  node* x_parent = nullptr;
+
+  if (y->left_ == nullptr) {
+    x = y->right_;
+  } else if (y->right_ == nullptr) {
+    x = y->left_;
+  } else {
+    // two children: z's successor takes its place.
+    y = minimum(y->right_);
+    x = y->right_;
+  }
+
+  if (y != &z) {
+    z.left_->set_parent(y);
+    y->left_ = z.left_;
+    if (y != z.right_) {
+      x_parent = y->parent();
+      if (x != nullptr) {
+        x->set_parent(x_parent);
+      }
+      x_parent->left_ = x;
+      y->right_ = z.right_;
+      z.right_->set_parent(y);
+    } else {
+      x_parent = y;
+    }
+    node* zp = z.parent();
+    if (zp == &header) {
+      set_root(header, y);
+    } else if (zp->left_ == &z) {
+      zp->left_ = y;
+    } else {
+      zp->right_ = y;
+    }
+    y->set_parent(zp);
+    bool y_red = y->is_red();
+    y->set_red(z.is_red());
+    z.set_red(y_red);
+  } else {
+    x_parent = z.parent();
+    if (x != nullptr) {
+      x->set_parent(x_parent);
+    }
+    if (x_parent == &header) {
+      set_root(header, x);
+    } else if (x_parent->left_ == &z) {
+      x_parent->left_ = x;
+    } else {
+      x_parent->right_ = x;
+    }
+    if (header.left_ == &z) {
+      header.left_ = z.right_ == nullptr ? x_parent : minimum(x);
+    }
+    if (header.right_ == &z) {
+      header.right_ = z.left_ == nullptr ? x_parent : maximum(x);
+    }
+  }
+
+  // z now holds the colour of the node that actually left the tree.
+  if (!z.is_red()) {
+    while (x != header.parent() && (x == nullptr || !x->is_red())) {
+      if (x == x_parent->left_) {
+        node* w = x_parent->right_;
+        if (w->is_red()) {
+          w->set_red(false);
+          x_parent->set_red(true);
+          rotate_left(header, x_parent);
+          w = x_parent->right_;
+        }
+        if ((w->left_ == nullptr || !w->left_->is_red()) &&
+            (w->right_ == nullptr || !w->right_->is_red())) {
+          w->set_red(true);
+          x = x_parent;
+          x_parent = x_parent->parent();
+        } else {
+          if (w->right_ == nullptr || !w->right_->is_red()) {
+            w->left_->set_red(false);
+            w->set_red(true);
+            rotate_right(header, w);
+            w = x_parent->right_;
+          }
+          w->set_red(x_parent->is_red());
+          x_parent->set_red(false);
+          if (w->right_ != nullptr) {
+            w->right_->set_red(false);
+          }
+          rotate_left(header, x_parent);
+          break;
+        }
+      } else {
+        node* w = x_parent->left_;
+        if (w->is_red()) {
+          w->set_red(false);
+          x_parent->set_red(true);
+          rotate_right(header, x_parent);
+          w = x_parent->left_;
+        }
+        if ((w->right_ == nullptr || !w->right_->is_red()) &&
+            (w->left_ == nullptr || !w->left_->is_red())) {
+          w->set_red(true);
+          x = x_parent;
+          x_parent = x_parent->parent();
+        } else {
+          if (w->left_ == nullptr || !w->left_->is_red()) {
+            w->right_->set_red(false);
+            w->set_red(true);
+            rotate_left(header, w);
+            w = x_parent->left_;
+          }
+          w->set_red(x_parent->is_red());
+          x_parent->set_red(false);
+          if (w->left_ != nullptr) {
+            w->left_->set_red(false);
+          }
+          rotate_right(header, x_parent);
+          break;
+        }
+      }
+    }
+    if (x != nullptr) {
+      x->set_red(false);
+    }
+  }
+
+  z.parent_ = 0;
+  z.left_ = nullptr;
+  z.right_ = nullptr;
+}
+} // namespace details
+
+inline void intrusive_rbtree_node::unlink() {
+  if (!is_linked() || is_header()) {
+    return;
+  }
+  intrusive_rbtree_node* header = parent();
+  while (!header->is_header()) {
+    header = header->parent();
+  }
+  details::rbtree_base::erase_and_rebalance(*header, *this);
+}
+
+inline void intrusive_rbtree_node::replace(intrusive_rbtree_node& other) {
+  parent_ = other.parent_;
+  left_ = other.left_;
+  right_ = other.right_;
+  other.parent_ = 0;
+  other.left_ = nullptr;
+  other.right_ = nullptr;
+  intrusive_rbtree_node* p = parent();
+  if (p == nullptr) {
+    return;
+  }
+  if (p->is_header()) {
+    p->set_parent(this);
+  } else if (p->left_ == &other) {
+    p->left_ = this;
+  } else {
+    p->right_ = this;
+  }
+  if (left_ != nullptr) {
+    left_->set_parent(this);
+  }
+  if (right_ != nullptr) {
+    right_->set_parent(this);
+  }
+  // the header's leftmost/rightmost may also name `other`.
+  intrusive_rbtree_node* header = p;
+  while (!header->is_header()) {
+    header = header->parent();
+  }
+  if (header->left_ == &other) {
+    header->left_ = this;
+  }
+  if (header->right_ == &other) {
+    header->right_ = this;
+  }
+}
+
+template <typename T, intrusive_rbtree_node T::*node_ptr, bool isConst = false>
+class set_iterator {
+public:
+  using value_type = std::conditional_t<isConst, const T, T>;
+  using pointer = value_type*;
+  using reference = value_type&;
+  using difference_type = std::ptrdiff_t;
+  using iterator_category = std::bidirectional_iterator_tag;
+
+  using node = std::conditional_t<isConst, const intrusive_rbtree_node, intrusive_rbtree_node>;
+  node* ptr_;
+
+  explicit set_iterator(node* ptr) : ptr_(ptr) {}
+
+  // iterator -> const_iterator.
+  template <bool wasConst, typename = std::enable_if_t<isConst && !wasConst>>
+  set_iterator(const set_iterator<T, node_ptr, wasConst>& other) : ptr_(other.ptr_) {}
+
+  reference operator*() const {
+    assert(ptr_ != nullptr);
+    return *(ptr_->template owner<T, node_ptr>());
+  }
+
+  pointer operator->() const { return ptr_->template owner<T, node_ptr>(); }
+
+  set_iterator& operator++() {
+    ptr_ = details::rbtree_base::next(ptr_);
+    return *this;
+  }
+
+  set_iterator operator++(int) {
+    set_iterator prev = *this;
+    operator++();
+    return prev;
+  }
+
+  set_iterator& operator--() {
+    ptr_ = details::rbtree_base::prev(ptr_);
+    return *this;
+  }
+
+  set_iterator operator--(int) {
+    set_iterator prev = *this;
+    operator--();
+    return prev;
+  }
+
+  constexpr bool operator==(const set_iterator& rhs) const { return ptr_ == rhs.ptr_; }
+  constexpr bool operator!=(const set_iterator& rhs) const { return !(*this == rhs); }
+};
+
+// Ordered set of T with unique keys under `Compare`, a red-black tree linked through an
+// intrusive_rbtree_node in T. insert, erase, find and the bounds are O(log n) and never allocate.
+// Lookups take anything `Compare` can compare against T in both argument orders.
+template <typename T, intrusive_rbtree_node T::*node_ptr, typename Compare = std::less<T>>
+class intrusive_set : public details::rbtree_base {
+  using base = details::rbtree_base;
+  using node = intrusive_rbtree_node;
+
+public:
+  using value_type = T;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using pointer = value_type*;
+  using const_pointer = const value_type*;
+  using difference_type = std::ptrdiff_t;
+  using size_type = std::size_t;
+  using key_compare = Compare;
+
+  using iterator = set_iterator<T, node_ptr>;
+  using const_iterator = set_iterator<T, node_ptr, true>;
+
+  explicit intrusive_set(Compare comp = Compare{}) : comp_(std::move(comp)) {}
+
+  intrusive_set(intrusive_set&&) noexcept = default;
+  intrusive_set& operator=(intrusive_set&&) noexcept = default;
+
+  // Links `val` unless an equivalent element is present. Returns the element now in the set and
+  // whether it is `val`.
+  std::pair<iterator, bool> insert(reference val) {
+    node* parent = end_node();
+    node* n = root();
+    bool left = true;
+    while (n != nullptr) {
+      parent = n;
+      left = comp_(val, value(n));
+      n = left ? left_of(n) : right_of(n);
+    }
+    // `val` goes next to `parent`; an equal element, if any, is parent or its predecessor.
+    iterator candidate{parent};
+    if (left) {
+      if (parent == leftmost()) {
+        insert_at(val.*node_ptr, parent, true);
+        return {iterator{&(val.*node_ptr)}, true};
+      }
+      --candidate;
+    }
+    if (comp_(*candidate, val)) {
+      insert_at(val.*node_ptr, parent, left);
+      return {iterator{&(val.*node_ptr)}, true};
+    }
+    return {candidate, false};
+  }
+
+  // Unlinks `val`, which must be an element of this set.
+  void erase(reference val) { base::erase(val.*node_ptr); }
+
+  // Unlinks the element at `pos`, returning the element after it.
+  iterator erase(const_iterator pos) {
+    assert(pos != end());
+    node* n = const_cast<node*>(pos.ptr_);
+    iterator following{base::next(n)};
+    base::erase(*n);
+    return following;
+  }
+
+  // first element not less than `key`.
+  template <typename K>
+  iterator lower_bound(const K& key) {
+    node* result = end_node();
+    for (node* n = root(); n != nullptr;) {
+      if (comp_(value(n), key)) {
+        n = right_of(n);
+      } else {
+        result = n;
+        n = left_of(n);
+      }
+    }
+    return iterator{result};
+  }
+
+  template <typename K>
+  const_iterator lower_bound(const K& key) const {
+    return const_cast<intrusive_set*>(this)->lower_bound(key);
+  }
+
+  // first element greater than `key`.
+  template <typename K>
+  iterator upper_bound(const K& key) {
+    node* result = end_node();
+    for (node* n = root(); n != nullptr;) {
+      if (comp_(key, value(n))) {
+        result = n;
+        n = left_of(n);
+      } else {
+        n = right_of(n);
+      }
+    }
+    return iterator{result};
+  }
+
+  template <typename K>
+  const_iterator upper_bound(const K& key) const {
+    return const_cast<intrusive_set*>(this)->upper_bound(key);
+  }
+
+  template <typename K>
+  iterator find(const K& key) {
+    iterator it = lower_bound(key);
+    return it != end() && !comp_(key, *it) ? it : end();
+  }
+
+  template <typename K>
+  const_iterator find(const K& key) const {
+    return const_cast<intrusive_set*>(this)->find(key);
+  }
+
+  reference front() {
+    assert(!empty());
+    return value(leftmost());
+  }
+
+  reference back() {
+    assert(!empty());
+    return value(rightmost());
+  }
+
+  iterator begin() { return iterator{leftmost()}; }
+  const_iterator begin() const { return const_iterator{leftmost()}; }
+  const_iterator cbegin() const { return begin(); }
+  iterator end() { return iterator{end_node()}; }
+  const_iterator end() const { return const_iterator{end_node()}; }
+  const_iterator cend() const { return end(); }
+
+private:
+  static reference value(node* n) { return *(n->template owner<T, node_ptr>()); }
+
+  Compare comp_;
+};
+} // namespace pep
@@ -0,0 +1,390 @@
+/*
+ * intrusive_slist.hpp Copyright © 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#pragma once
+#include "intrusive_list.hpp"
+#ifndef STUPIDLY_STD_COMPLIANT
+namespace std {
+struct forward_iterator_tag;
+}
+#endif
+
+namespace pep {
+
+namespace details {
+class islist_base;
+struct cache_last_option_kind;
+} // namespace details
+
+// Keeps a pointer to the last element in the list header, making back()/push_back() O(1) and the
+// list's move operations O(1) instead of O(n).
+template <bool Enabled>
+struct cache_last {
+  using option_kind = details::cache_last_option_kind;
+  static constexpr bool value = Enabled;
+};
+
+// Singly-linked hook, one pointer of overhead. Lists are circular, so a linked node never has a
+// null next pointer. A node can't unlink itself without its predecessor, so unlike intrusive_node
+// it must be removed through its list before being destroyed or moved.
+struct intrusive_slist_node {
+private:
+  friend details::islist_base;
+  intrusive_slist_node* next_{nullptr};
+
+public:
+  constexpr intrusive_slist_node() noexcept = default;
+  constexpr intrusive_slist_node(const intrusive_slist_node& other) = delete;
+  constexpr intrusive_slist_node(intrusive_slist_node&& other) noexcept {
+    assert(!other.is_linked() && "moved a linked slist node.");
+    static_cast<void>(other);
+  }
+
+  ~intrusive_slist_node() { assert(!is_linked() && "destroyed a linked slist node."); }
+
+  constexpr intrusive_slist_node& operator=(const intrusive_slist_node&) = delete;
+  constexpr intrusive_slist_node& operator=(intrusive_slist_node&& other) noexcept {
+    assert(!is_linked() && !other.is_linked() && "moved a linked slist node.");
+    static_cast<void>(other);
+    return *this;
+  }
+
+  constexpr intrusive_slist_node* get_next() { return next_; }
+  constexpr intrusive_slist_node* get_next() const { return next_; }
+  constexpr void set_next(intrusive_slist_node* n) {
+    assert(n != this && "attempted to link to self.");
+    next_ = n;
+  }
+
+  constexpr bool is_linked() const { return get_next() != nullptr; }
+
+  template <typename T, intrusive_slist_node T::*mem_p>
+  const T* owner() const {
+    return details::owner_of<T, intrusive_slist_node, mem_p>(this);
+  }
+
+  template <typename T, intrusive_slist_node T::*mem_p>
+  T* owner() {
+    return const_cast<T*>(const_cast<const intrusive_slist_node*>(this)->owner<T, mem_p>());
+  }
+};
+
+template <typename T, intrusive_slist_node T::*node_ptr, bool isConst = false>
+class slist_iterator {
+public:
+  using value_type = std::conditional_t<isConst, const T, T>;
+  using pointer = value_type*;
+  using reference = value_type&;
+  using difference_type = std::ptrdiff_t;
+  using iterator_category = std::forward_iterator_tag;
+
+  using node = std::conditional_t<isConst, const intrusive_slist_node, intrusive_slist_node>;
+  node* ptr_;
+
+  explicit slist_iterator(node* ptr) : ptr_(ptr) {}
+
+  reference operator*() const {
+    assert(ptr_ != nullptr);
+    return *(ptr_->template owner<T, node_ptr>());
+  }
+
+  pointer operator->() const { return ptr_->template owner<T, node_ptr>(); }
+
+  slist_iterator& operator++() {
+    assert(ptr_);
+    ptr_ = ptr_->get_next();
+    return *this;
+  }
+
+  slist_iterator operator++(int) {
+    slist_iterator prev = *this;
+    operator++();
+    return prev;
+  }
+
+  constexpr bool operator==(const slist_iterator& rhs) const { return ptr_ == rhs.ptr_; }
+  constexpr bool operator!=(const slist_iterator& rhs) const { return !(*this == rhs); }
+};
+
+namespace details {
+class islist_base {
+public:
+  using difference_type = std::ptrdiff_t;
+  using size_type = std::size_t;
+
+  inline islist_base() noexcept;
+
+  islist_base(const islist_base&) = delete;
+  islist_base& operator=(const islist_base&) = delete;
+
+  // O(n), the last node has to be found to point it at the new sentinel. See cache_last.
+  inline islist_base(islist_base&& other) noexcept;
+  inline islist_base& operator=(islist_base&&) noexcept;
+
+  inline ~islist_base();
+
+  [[nodiscard]] inline bool empty() const;
+  // O(n).
+  [[nodiscard]] inline size_type size() const;
+  inline void insert_after(intrusive_slist_node& pos, intrusive_slist_node& val);
+  inline void erase_after(intrusive_slist_node& pos);
+  inline void pop_front();
+
+  inline void clear();
+
+protected:
+  intrusive_slist_node* before_begin_node() { return &root_; }
+  const intrusive_slist_node* before_begin_node() const { return &root_; }
+  intrusive_slist_node* end_node() { return &root_; }
+  const intrusive_slist_node* end_node() const { return &root_; }
+
+  inline intrusive_slist_node* find_last();
+  // takes over `other`'s nodes given its last node.
+  inline void move_from(islist_base& other, intrusive_slist_node* other_last) noexcept;
+
+private:
+  inline void reset() noexcept;
+
+  intrusive_slist_node root_{};
+};
+
+inline islist_base::islist_base() noexcept {
+  reset();
+}
+
+inline void islist_base::reset() noexcept {
+  // the sentinel links to itself, which set_next refuses to do.
+  root_.next_ = &root_;
+}
+
+inline intrusive_slist_node* islist_base::find_last() {
+  intrusive_slist_node* n = &root_;
+  while (n->next_ != &root_) {
+    n = n->next_;
+  }
+  return n;
+}
+
+inline void islist_base::move_from(islist_base& other, intrusive_slist_node* other_last) noexcept {
+  if (other.empty()) {
+    reset();
+  } else {
+    root_.next_ = other.root_.next_;
+    other_last->next_ = &root_;
+  }
+  other.reset();
+}
+
+inline islist_base::islist_base(islist_base&& other) noexcept {
+  move_from(other, other.find_last());
+}
+
+inline auto islist_base::operator=(islist_base&& other) noexcept -> islist_base& {
+  clear();
+  move_from(other, other.find_last());
+  return *this;
+}
+
+inline islist_base::~islist_base() {
+  clear();
+  root_.next_ = nullptr;
+}
+
+inline bool islist_base::empty() const {
+  return root_.next_ == &root_;
+}
+
+inline islist_base::size_type islist_base::size() const {
+  size_type count = 0;
+  for (const intrusive_slist_node* n = root_.next_; n != &root_; n = n->next_) {
+    ++count;
+  }
+  return count;
+}
+
+inline void islist_base::insert_after(intrusive_slist_node& pos, intrusive_slist_node& val) {
+  assert(pos.is_linked() && "inserting after a node that isn't in a list.");
+  assert(!val.is_linked() && "this node is already part of a list.");
+  val.next_ = pos.next_;
+  pos.next_ = &val;
+}
+
+inline void islist_base::erase_after(intrusive_slist_node& pos) {
+  intrusive_slist_node* n = pos.next_;
+  assert(n != &root_ && "Invalid node.");
+  pos.next_ = n->next_;
+  n->next_ = nullptr;
+}
+
+inline void islist_base::pop_front() {
+  assert(!empty());
+  erase_after(root_);
+}
+
+inline void islist_base::clear() {
+  intrusive_slist_node* n = root_.next_;
+  while (n != &root_) {
+    intrusive_slist_node* next = n->next_;
+    n->next_ = nullptr;
+    n = next;
+  }
+  reset();
+}
+
+// Tracks the last node on top of islist_base when cache_last<true> is requested.
+template <typename Base, bool CacheLast>
+class islist_last_cache : public Base {};
+
+template <typename Base>
+class islist_last_cache<Base, true> : public Base {
+public:
+  islist_last_cache() noexcept : last_(this->before_begin_node()) {}
+
+  islist_last_cache(islist_last_cache&& other) noexcept : islist_last_cache() {
+    take(other);
+  }
+
+  islist_last_cache& operator=(islist_last_cache&& other) noexcept {
+    clear();
+    take(other);
+    return *this;
+  }
+
+  void insert_after(intrusive_slist_node& pos, intrusive_slist_node& val) {
+    Base::insert_after(pos, val);
+    if (&pos == last_) {
+      last_ = &val;
+    }
+  }
+
+  void erase_after(intrusive_slist_node& pos) {
+    if (pos.get_next() == last_) {
+      last_ = &pos;
+    }
+    Base::erase_after(pos);
+  }
+
+  void pop_front() {
+    assert(!this->empty());
+    erase_after(*this->before_begin_node());
+  }
+
+  void clear() {
+    Base::clear();
+    last_ = this->before_begin_node();
+  }
+
+protected:
+  intrusive_slist_node* last_node() { return last_; }
+  const intrusive_slist_node* last_node() const { return last_; }
+
+private:
+  void take(islist_last_cache& other) noexcept {
+    bool other_empty = other.empty();
+    this->move_from(other, other.last_);
+    last_ = other_empty ? this->before_begin_node() : other.last_;
+    other.last_ = other.before_begin_node();
+  }
+
+  intrusive_slist_node* last_;
+};
+
+template <typename... Options>
+struct slist_options {
+  static constexpr bool cache_last =
+    find_option<cache_last_option_kind, pep::cache_last<false>, Options...>::type::value;
+
+  using base = islist_last_cache<islist_base, cache_last>;
+};
+} // namespace details
+
+template <typename T, intrusive_slist_node T::*node_ptr, typename... Options>
+class intrusive_slist : public details::slist_options<Options...>::base {
+  using options = details::slist_options<Options...>;
+  using base = typename options::base;
+  using base::before_begin_node;
+  using base::end_node;
+  using base::erase_after;
+  using base::insert_after;
+
+public:
+  using base::empty;
+
+  using value_type = T;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using pointer = value_type*;
+  using const_pointer = const value_type*;
+  using difference_type = std::ptrdiff_t;
+  using size_type = std::size_t;
+
+  using iterator = pep::slist_iterator<T, node_ptr>;
+  using const_iterator = pep::slist_iterator<T, node_ptr, true>;
+
+  reference front() {
+    assert(!empty());
+    return *(before_begin_node()->get_next()->template owner<T, node_ptr>());
+  }
+
+  const_reference front() const {
+    assert(!empty());
+    return *(before_begin_node()->get_next()->template owner<T, node_ptr>());
+  }
+
+  reference back() {
+    static_assert(options::cache_last, "back() requires cache_last<true>.");
+    assert(!empty());
+    return *(this->last_node()->template owner<T, node_ptr>());
+  }
+
+  const_reference back() const {
+    static_assert(options::cache_last, "back() requires cache_last<true>.");
+    assert(!empty());
+    return *(this->last_node()->template owner<T, node_ptr>());
+  }
+
+  void push_front(reference val) { insert_after(*before_begin_node(), val.*node_ptr); }
+
+  void push_back(reference val) {
+    static_assert(options::cache_last, "push_back() requires cache_last<true>.");
+    insert_after(*this->last_node(), val.*node_ptr);
+  }
+
+  void insert_after(pointer pos, reference val) {
+    assert(pos != nullptr && "can't insert after a null pointer.");
+    insert_after(pos->*node_ptr, val.*node_ptr);
+  }
+
+  // `pos` may be before_begin().
+  void insert_after(iterator pos, reference val) {
+    assert(pos.ptr_ != nullptr);
+    insert_after(*pos.ptr_, val.*node_ptr);
+  }
+
+  void erase_after(pointer pos) {
+    assert(pos != nullptr);
+    erase_after(pos->*node_ptr);
+  }
+
+  // `pos` may be before_begin().
+  void erase_after(iterator pos) {
+    assert(pos.ptr_ != nullptr);
+    erase_after(*pos.ptr_);
+  }
+
+  // the sentinel is both before the first element and past the last one, so before_begin() ==
+  // end().
+  iterator before_begin() { return iterator{before_begin_node()}; }
+  const_iterator before_begin() const { return const_iterator{before_begin_node()}; }
+  const_iterator cbefore_begin() const { return before_begin(); }
+  iterator begin() { return iterator{before_begin_node()->get_next()}; }
+  const_iterator begin() const { return const_iterator{before_begin_node()->get_next()}; }
+  const_iterator cbegin() const { return begin(); }
+  iterator end() { return iterator{end_node()}; }
+  const_iterator end() const { return const_iterator{end_node()}; }
+  const_iterator cend() const { return end(); }
+};
+} // namespace pep
@@ -0,0 +1,148 @@
+/*
+ * intrusive_spsc_queue.hpp Copyright © 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#pragma once
+#include "intrusive_list.hpp"
+#include <atomic>
+
+namespace pep {
+
+struct intrusive_spsc_node;
+template <typename T, intrusive_spsc_node T::*node_ptr>
+class intrusive_spsc_queue;
+
+// Hook for intrusive_spsc_queue, a single atomic next pointer. Nodes don't know whether they are
+// queued, so an element must be popped before it is destroyed.
+struct intrusive_spsc_node {
+private:
+  template <typename T, intrusive_spsc_node T::*node_ptr>
+  friend class intrusive_spsc_queue;
+  std::atomic<intrusive_spsc_node*> next_{nullptr};
+
+public:
+  constexpr intrusive_spsc_node() noexcept = default;
+  intrusive_spsc_node(const intrusive_spsc_node&) = delete;
+  intrusive_spsc_node& operator=(const intrusive_spsc_node&) = delete;
+
+  // for building a chain to hand to push_chain(). Not synchronized, the chain must be private to
+  // the producer until it's published.
+  void set_next(intrusive_spsc_node* n) {
+    assert(n != this && "attempted to link to self.");
+    next_.store(n, std::memory_order_relaxed);
+  }
+
+  template <typename T, intrusive_spsc_node T::*mem_p>
+  const T* owner() const {
+    return details::owner_of<T, intrusive_spsc_node, mem_p>(this);
+  }
+
+  template <typename T, intrusive_spsc_node T::*mem_p>
+  T* owner() {
+    return const_cast<T*>(const_cast<const intrusive_spsc_node*>(this)->owner<T, mem_p>());
+  }
+};
+
+// Single-producer single-consumer queue after Vyukov's unbounded SPSC design. The producer's end
+// and the consumer's end live on separate cache lines, and neither thread ever writes to the
+// other's.
+//
+// The queue always keeps one node, its dummy: at first a stub of its own, afterwards the hook of
+// the element popped last. The consumer never takes the last node, so the producer can link onto it
+// at any time. push() is wait-free: a release store into the tail's next pointer and a plain store
+// to the producer's own tail. pop() is a single acquire load. Nothing is ever allocated. Because
+// of the dummy, an element returned by pop() lends its hook to the queue until the next pop, see
+// pop().
+template <typename T, intrusive_spsc_node T::*node_ptr>
+class intrusive_spsc_queue {
+public:
+  using value_type = T;
+  using reference = value_type&;
+  using pointer = value_type*;
+
+  intrusive_spsc_queue() noexcept : tail_(&stub_), head_(&stub_) {}
+
+  intrusive_spsc_queue(const intrusive_spsc_queue&) = delete;
+  intrusive_spsc_queue& operator=(const intrusive_spsc_queue&) = delete;
+
+  // Producer only. `val` must not be the element popped last: its hook is still the queue's dummy
+  // until the consumer pops the element after it.
+  void push(reference val) { push_nodes(val.*node_ptr, val.*node_ptr); }
+
+  // Publishes `first` .. `last`, already linked through intrusive_spsc_node::set_next(), with a
+  // single release store. Producer only.
+  void push_chain(reference first, reference last) { push_nodes(first.*node_ptr, last.*node_ptr); }
+
+  // Links [first, last) locally and publishes it with push_chain(). `It` dereferences to T&.
+  // Producer only.
+  template <typename It>
+  void push_range(It first, It last) {
+    if (first == last) {
+      return;
+    }
+    reference head = *first;
+    intrusive_spsc_node* prev = &(head.*node_ptr);
+    for (++first; first != last; ++first) {
+      intrusive_spsc_node* n = &((*first).*node_ptr);
+      prev->set_next(n);
+      prev = n;
+    }
+    push_nodes(head.*node_ptr, *prev);
+  }
+
+  // Consumer only. Returns null if the queue is empty. The element popped before this one is
+  // released. The returned element's hook stays in the queue as its dummy, and the producer's next
+  // push writes into it, so until the next successful pop the element must not be pushed again, to
+  // any queue, nor destroyed. Its other members are the consumer's right away.
+  pointer pop() {
+    intrusive_spsc_node* next = head_->next_.load(std::memory_order_acquire);
+    if (next == nullptr) {
+      return nullptr;
+    }
+    head_ = next;
+    return next->template owner<T, node_ptr>();
+  }
+
+  // Pops up to `max` elements in one pass down the queue, writing a T* for each to `out`. Returns
+  // how many were popped; all but the last of them are released right away. Consumer only.
+  template <typename OutIt>
+  std::size_t pop_bulk(OutIt out, std::size_t max) {
+    intrusive_spsc_node* head = head_;
+    std::size_t count = 0;
+    for (; count != max; ++count) {
+      intrusive_spsc_node* next = head->next_.load(std::memory_order_acquire);
+      if (next == nullptr) {
+        break;
+      }
+      *out = next->template owner<T, node_ptr>();
+      ++out;
+      head = next;
+    }
+    head_ = head;
+    return count;
+  }
+
+  // Consumer only. May report empty while a push is in flight.
+  [[nodiscard]] bool empty() const {
+    return head_->next_.load(std::memory_order_acquire) == nullptr;
+  }
+
+private:
+  void push_nodes(intrusive_spsc_node& first, intrusive_spsc_node& last) {
+    assert(&first != tail_ && &last != tail_ &&
+           "pushing the queue's dummy, the element popped last.");
+    last.next_.store(nullptr, std::memory_order_relaxed);
+    // publishes the chain's inner links too.
+    tail_->next_.store(&first, std::memory_order_release);
+    tail_ = &last;
+  }
+
+  // producer only.
+  alignas(details::cache_line_size) intrusive_spsc_node* tail_;
+  // consumer only.
+  alignas(details::cache_line_size) intrusive_spsc_node* head_;
+  intrusive_spsc_node stub_;
+};
+} // namespace pep
@@ -0,0 +1,154 @@
+/*
+ * intrusive_timer_wheel.hpp Copyright © 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#pragma once
+#include "intrusive_list.hpp"
+
+namespace pep {
+
+// Hierarchical timing wheel over timers that embed an intrusive_node and keep their expiry tick in
+// `expiry_ptr`. Every slot is an intrusive_list, so nothing is ever allocated:
+//   - schedule() is O(1), it links the timer into the slot chosen by its expiry.
+//   - cancel() is O(1), it just unlinks the node; destroying a scheduled timer cancels it too.
+//   - advance() walks the elapsed ticks. Timers in a slot of a coarser level are cascaded into
+//     finer slots as the wheel reaches them, one relink each, so every timer is moved at most once
+//     per level: amortised O(1) per tick and per timer.
+//
+// Level l has 64 slots of 64^l ticks each. Six levels cover 2^36 ticks ahead of now(); anything
+// further out waits on an overflow list that is re-examined every 2^36 ticks.
+template <typename T, intrusive_node T::*node_ptr, std::uint64_t T::*expiry_ptr>
+class intrusive_timer_wheel {
+  using slot_list = intrusive_list<T, node_ptr, circular_layout>;
+
+public:
+  using value_type = T;
+  using reference = value_type&;
+  using size_type = std::size_t;
+
+  static constexpr unsigned bits_per_level = 6;
+  static constexpr unsigned levels = 6;
+  static constexpr std::size_t slots_per_level = std::size_t{1} << bits_per_level;
+
+  explicit intrusive_timer_wheel(std::uint64_t now = 0) noexcept : now_(now) {}
+
+  intrusive_timer_wheel(const intrusive_timer_wheel&) = delete;
+  intrusive_timer_wheel& operator=(const intrusive_timer_wheel&) = delete;
+
+  // the last tick advance() processed.
+  std::uint64_t now() const { return now_; }
+
+  static bool is_scheduled(const T& timer) { return (timer.*node_ptr).is_linked(); }
+
+  // Schedules the unscheduled `timer` to fire at tick `expiry`, or on the next tick if that has
+  // already passed.
+  void schedule(reference timer, std::uint64_t expiry) {
+    assert(!is_scheduled(timer) && "timer is already scheduled.");
+    timer.*expiry_ptr = expiry;
+    place(timer, expiry > now_ ? expiry : now_ + 1).push_back(timer);
+  }
+
+  // Unschedules `timer`. Returns whether it was scheduled.
+  bool cancel(reference timer) {
+    if (!is_scheduled(timer)) {
+      return false;
+    }
+    (timer.*node_ptr).remove_from_list();
+    return true;
+  }
+
+  void reschedule(reference timer, std::uint64_t expiry) {
+    cancel(timer);
+    schedule(timer, expiry);
+  }
+
+  // Processes every tick up to and including `now`, calling `on_expire(T&)` for each timer that
+  // comes due, in tick order. Expired timers are unscheduled before their callback runs, which may
+  // schedule timers again. Returns how many expired.
+  template <typename F>
+  size_type advance(std::uint64_t now, F&& on_expire) {
+    size_type expired = 0;
+    while (now_ < now) {
+      ++now_;
+      cascade();
+      slot_list& slot = wheel_[0][now_ & slot_mask];
+      if (slot.empty()) {
+        continue;
+      }
+      slot_list due;
+      due.splice(due.end(), slot);
+      while (!due.empty()) {
+        T& timer = due.front();
+        due.pop_front();
+        ++expired;
+        on_expire(timer);
+      }
+    }
+    return expired;
+  }
+
+  // Unschedules every timer.
+  void clear() {
+    for (auto& level : wheel_) {
+      for (slot_list& slot : level) {
+        slot.clear();
+      }
+    }
+    overflow_.clear();
+  }
+
+private:
+  static constexpr std::uint64_t slot_mask = slots_per_level - 1;
+  static constexpr unsigned wheel_bits = bits_per_level * levels;
+
+  // the slot for a timer expiring at `expiry` >= now_: the finest level on which expiry and now_
+  // only differ in that level's digit.
+  slot_list& place(reference, std::uint64_t expiry) {
+    std::uint64_t diff = expiry ^ now_;
+    if ((diff >> wheel_bits) != 0) {
+      return overflow_;
+    }
+    unsigned level = 0;
+    while ((diff >> (bits_per_level * (level + 1))) != 0) {
+      ++level;
+    }
+    return wheel_[level][(expiry >> (bits_per_level * level)) & slot_mask];
+  }
+
+  // re-places the timers of every slot whose span starts at now_, coarsest first so that a timer
+  // can drop several levels in one tick.
+  void cascade() {
+    if ((now_ & slot_mask) != 0) {
+      return;
+    }
+    if ((now_ & ((std::uint64_t{1} << wheel_bits) - 1)) == 0) {
+      redistribute(overflow_);
+    }
+    for (unsigned level = levels - 1; level != 0; --level) {
+      unsigned shift = bits_per_level * level;
+      if ((now_ & ((std::uint64_t{1} << shift) - 1)) == 0) {
+        redistribute(wheel_[level][(now_ >> shift) & slot_mask]);
+      }
+    }
+  }
+
+  void redistribute(slot_list& slot) {
+    if (slot.empty()) {
+      return;
+    }
+    slot_list pending;
+    pending.splice(pending.end(), slot);
+    while (!pending.empty()) {
+      T& timer = pending.front();
+      slot_list& target = place(timer, timer.*expiry_ptr);
+      target.splice(target.end(), pending, pending.begin());
+    }
+  }
+
+  std::uint64_t now_;
+  slot_list wheel_[levels][slots_per_level];
+  slot_list overflow_;
+};
+} // namespace pep
@@ -0,0 +1,291 @@
+/*
+ * intrusive_xor_list.hpp Copyright © 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#pragma once
+#include "intrusive_list.hpp"
+
+namespace pep {
+
+namespace details {
+class ixlist_base;
+} // namespace details
+
+// XOR-linked hook: a single word holding `prev ^ next`, half the size of intrusive_node while still
+// allowing traversal in both directions. A node's neighbours can only be recovered while walking
+// the list, so there is no unlink by reference and no auto-unlink; elements are erased through an
+// iterator and must be erased (or the list cleared) before they are destroyed or moved.
+struct intrusive_xor_node {
+private:
+  friend details::ixlist_base;
+  std::uintptr_t link_{0};
+
+public:
+  constexpr intrusive_xor_node() noexcept = default;
+  constexpr intrusive_xor_node(const intrusive_xor_node& other) = delete;
+  // nodes can't be relinked from the outside, a moved-to node starts out unlinked.
+  constexpr intrusive_xor_node(intrusive_xor_node&&) noexcept {}
+
+  constexpr intrusive_xor_node& operator=(const intrusive_xor_node&) = delete;
+  constexpr intrusive_xor_node& operator=(intrusive_xor_node&&) noexcept { return *this; }
+
+  // given one neighbour, returns the other.
+  intrusive_xor_node* other(const intrusive_xor_node* neighbour) const {
+    return reinterpret_cast<intrusive_xor_node*>(link_ ^
+                                                 reinterpret_cast<std::uintptr_t>(neighbour));
+  }
+
+  template <typename T, intrusive_xor_node T::*mem_p>
+  const T* owner() const {
+    return details::owner_of<T, intrusive_xor_node, mem_p>(this);
+  }
+
+  template <typename T, intrusive_xor_node T::*mem_p>
+  T* owner() {
+    return const_cast<T*>(const_cast<const intrusive_xor_node*>(this)->owner<T, mem_p>());
+  }
+};
+
+// A position in an XOR list is the pair (prev, cur); either may be null at the ends. end() is
+// (back, null).
+template <typename T, intrusive_xor_node T::*node_ptr, bool isConst = false>
+class xor_list_iterator {
+public:
+  using value_type = std::conditional_t<isConst, const T, T>;
+  using pointer = value_type*;
+  using reference = value_type&;
+  using difference_type = std::ptrdiff_t;
+  using iterator_category = std::bidirectional_iterator_tag;
+
+  using node = intrusive_xor_node;
+  node* prev_;
+  node* ptr_;
+
+  xor_list_iterator(node* prev, node* ptr) : prev_(prev), ptr_(ptr) {}
+
+  // iterator -> const_iterator.
+  template <bool wasConst, typename = std::enable_if_t<isConst && !wasConst>>
+  xor_list_iterator(const xor_list_iterator<T, node_ptr, wasConst>& other)
+      : prev_(other.prev_), ptr_(other.ptr_) {}
+
+  reference operator*() const {
+    assert(ptr_ != nullptr);
+    return *(ptr_->template owner<T, node_ptr>());
+  }
+
+  pointer operator->() const { return ptr_->template owner<T, node_ptr>(); }
+
+  xor_list_iterator& operator++() {
+    assert(ptr_);
+    node* next = ptr_->other(prev_);
+    prev_ = ptr_;
+    ptr_ = next;
+    return *this;
+  }
+
+  xor_list_iterator operator++(int) {
+    xor_list_iterator old = *this;
+    operator++();
+    return old;
+  }
+
+  xor_list_iterator& operator--() {
+    assert(prev_);
+    node* prev = prev_->other(ptr_);
+    ptr_ = prev_;
+    prev_ = prev;
+    return *this;
+  }
+
+  xor_list_iterator operator--(int) {
+    xor_list_iterator old = *this;
+    operator--();
+    return old;
+  }
+
+  constexpr bool operator==(const xor_list_iterator& rhs) const {
+    return ptr_ == rhs.ptr_ && prev_ == rhs.prev_;
+  }
+  constexpr bool operator!=(const xor_list_iterator& rhs) const { return !(*this == rhs); }
+};
+
+namespace details {
+class ixlist_base {
+public:
+  using difference_type = std::ptrdiff_t;
+  using size_type = std::size_t;
+
+  ixlist_base() noexcept = default;
+
+  ixlist_base(const ixlist_base&) = delete;
+  ixlist_base& operator=(const ixlist_base&) = delete;
+
+  inline ixlist_base(ixlist_base&& other) noexcept;
+  inline ixlist_base& operator=(ixlist_base&&) noexcept;
+
+  [[nodiscard]] bool empty() const { return head_ == nullptr; }
+  [[nodiscard]] bool is_empty() const { return empty(); }
+  // O(n).
+  [[nodiscard]] inline size_type size() const;
+
+  // links `val` between the adjacent nodes `prev` and `next`, either of which may be null.
+  inline void link_between(intrusive_xor_node* prev, intrusive_xor_node* next,
+                           intrusive_xor_node& val);
+  // unlinks `n` given its predecessor, returns its successor.
+  inline intrusive_xor_node* unlink(intrusive_xor_node* prev, intrusive_xor_node* n);
+  inline void pop_front();
+  inline void pop_back();
+
+  // O(1), there is no per-node state to reset.
+  void clear() {
+    head_ = nullptr;
+    tail_ = nullptr;
+  }
+
+protected:
+  static std::uintptr_t bits(const intrusive_xor_node* n) {
+    return reinterpret_cast<std::uintptr_t>(n);
+  }
+
+  intrusive_xor_node* head_{nullptr};
+  intrusive_xor_node* tail_{nullptr};
+};
+
+inline ixlist_base::ixlist_base(ixlist_base&& other) noexcept
+    : head_(other.head_), tail_(other.tail_) {
+  other.clear();
+}
+
+inline auto ixlist_base::operator=(ixlist_base&& other) noexcept -> ixlist_base& {
+  head_ = other.head_;
+  tail_ = other.tail_;
+  other.clear();
+  return *this;
+}
+
+inline ixlist_base::size_type ixlist_base::size() const {
+  size_type count = 0;
+  const intrusive_xor_node* prev = nullptr;
+  for (const intrusive_xor_node* n = head_; n != nullptr;) {
+    const intrusive_xor_node* next = n->other(prev);
+    prev = n;
+    n = next;
+    ++count;
+  }
+  return count;
+}
+
+inline void ixlist_base::link_between(intrusive_xor_node* prev, intrusive_xor_node* next,
+                                      intrusive_xor_node& val) {
+  assert(&val != prev && &val != next && "this node is already part of a list.");
+  val.link_ = bits(prev) ^ bits(next);
+  if (prev != nullptr) {
+    prev->link_ ^= bits(next) ^ bits(&val);
+  } else {
+    assert(head_ == next && "sanity error");
+    head_ = &val;
+  }
+  if (next != nullptr) {
+    next->link_ ^= bits(prev) ^ bits(&val);
+  } else {
+    assert(tail_ == prev && "sanity error");
+    tail_ = &val;
+  }
+}
+
+inline intrusive_xor_node* ixlist_base::unlink(intrusive_xor_node* prev, intrusive_xor_node* n) {
+  assert(n != nullptr && "Invalid node.");
+  intrusive_xor_node* next = n->other(prev);
+  if (prev != nullptr) {
+    prev->link_ ^= bits(n) ^ bits(next);
+  } else {
+    assert(head_ == n && "sanity error");
+    head_ = next;
+  }
+  if (next != nullptr) {
+    next->link_ ^= bits(n) ^ bits(prev);
+  } else {
+    assert(tail_ == n && "sanity error");
+    tail_ = prev;
+  }
+  n->link_ = 0;
+  return next;
+}
+
+inline void ixlist_base::pop_front() {
+  assert(!empty());
+  unlink(nullptr, head_);
+}
+
+inline void ixlist_base::pop_back() {
+  assert(!empty());
+  unlink(tail_->other(nullptr), tail_);
+}
+} // namespace details
+
+template <typename T, intrusive_xor_node T::*node_ptr>
+class intrusive_xor_list : public details::ixlist_base {
+  using details::ixlist_base::head_;
+  using details::ixlist_base::link_between;
+  using details::ixlist_base::tail_;
+  using details::ixlist_base::unlink;
+
+public:
+  using value_type = T;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using pointer = value_type*;
+  using const_pointer = const value_type*;
+  using difference_type = std::ptrdiff_t;
+  using size_type = std::size_t;
+
+  using iterator = pep::xor_list_iterator<T, node_ptr>;
+  using const_iterator = pep::xor_list_iterator<T, node_ptr, true>;
+
+  reference front() {
+    assert(!empty());
+    return *(head_->template owner<T, node_ptr>());
+  }
+
+  const_reference front() const {
+    assert(!empty());
+    return *(head_->template owner<T, node_ptr>());
+  }
+
+  reference back() {
+    assert(!empty());
+    return *(tail_->template owner<T, node_ptr>());
+  }
+
+  const_reference back() const {
+    assert(!empty());
+    return *(tail_->template owner<T, node_ptr>());
+  }
+
+  void push_front(reference val) { link_between(nullptr, head_, val.*node_ptr); }
+  void push_back(reference val) { link_between(tail_, nullptr, val.*node_ptr); }
+
+  // inserts `val` before `pos`, returns an iterator to it. Iterators to the neighbours of the new
+  // element are invalidated, since they store the old adjacency.
+  iterator insert(const_iterator pos, reference val) {
+    link_between(pos.prev_, pos.ptr_, val.*node_ptr);
+    return iterator{pos.prev_, &(val.*node_ptr)};
+  }
+
+  // returns an iterator to the element after `pos`. As with insert, iterators to the neighbours of
+  // the erased element are invalidated.
+  iterator erase(const_iterator pos) {
+    intrusive_xor_node* next = unlink(pos.prev_, pos.ptr_);
+    return iterator{pos.prev_, next};
+  }
+
+  iterator begin() { return iterator{nullptr, head_}; }
+  const_iterator begin() const { return const_iterator{nullptr, head_}; }
+  const_iterator cbegin() const { return begin(); }
+  iterator end() { return iterator{tail_, nullptr}; }
+  const_iterator end() const { return const_iterator{tail_, nullptr}; }
+  const_iterator cend() const { return end(); }
+};
+} // namespace pep
@@ -0,0 +1,108 @@
+/*
+ * intrusive_atomic_stack.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "../intrusive_atomic_stack.hpp"
+#include "doctest.h"
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+struct S {
+  int value;
+  std::atomic<int> owners{0};
+  pep::intrusive_stack_node n;
+};
+
+using stack = pep::intrusive_atomic_stack<S, &S::n>;
+using eliminating_stack = pep::intrusive_atomic_stack<S, &S::n, pep::elimination_backoff<4>>;
+} // namespace
+
+TEST_CASE_TEMPLATE("atomic stack single thread", St, doctest::Types<stack, eliminating_stack>) {
+  std::array<S, 5> arr;
+  for (int i = 0; i != 5; ++i) {
+    arr[i].value = i;
+  }
+  St s;
+  REQUIRE(s.empty());
+  REQUIRE(s.pop() == nullptr);
+  REQUIRE(s.pop_all().empty());
+
+  for (S& v : arr) {
+    s.push(v);
+  }
+  REQUIRE(!s.empty());
+  REQUIRE(s.pop() == &arr[4]);
+  REQUIRE(s.pop() == &arr[3]);
+
+  SUBCASE("pop_all") {
+    s.push(arr[4]);
+    auto chain = s.pop_all();
+    REQUIRE(s.empty());
+    REQUIRE(s.pop() == nullptr);
+    std::vector<int> seen;
+    for (S& v : chain) {
+      seen.push_back(v.value);
+    }
+    REQUIRE(seen == std::vector<int>{4, 2, 1, 0});
+  }
+  SUBCASE("reuse after drain") {
+    for (int round = 0; round != 3; ++round) {
+      while (s.pop() != nullptr) {
+      }
+      REQUIRE(s.empty());
+      for (S& v : arr) {
+        s.push(v);
+      }
+      for (int i = 4; i >= 0; --i) {
+        REQUIRE(s.pop() == &arr[i]);
+      }
+    }
+  }
+}
+
+TEST_CASE_TEMPLATE("atomic stack recycling threads", St, doctest::Types<stack, eliminating_stack>) {
+  // free list usage: every thread pops an element, checks nobody else holds it and pushes it
+  // back. An ABA on the top pointer would hand the same element to two threads at once.
+  constexpr int threads = 4;
+  constexpr int rounds = 50000;
+  std::vector<S> items(8);
+  St s;
+  for (S& v : items) {
+    s.push(v);
+  }
+
+  std::atomic<bool> exclusive{true};
+  std::vector<std::thread> workers;
+  for (int t = 0; t != threads; ++t) {
+    workers.emplace_back([&] {
+      for (int i = 0; i != rounds; ++i) {
+        S* v = s.pop();
+        if (v == nullptr) {
+          continue;
+        }
+        if (v->owners.fetch_add(1, std::memory_order_relaxed) != 0) {
+          exclusive = false;
+        }
+        v->owners.fetch_sub(1, std::memory_order_relaxed);
+        s.push(*v);
+      }
+    });
+  }
+  for (std::thread& w : workers) {
+    w.join();
+  }
+  REQUIRE(exclusive);
+
+  int count = 0;
+  for (S& v : s.pop_all()) {
+    (void)v;
+    ++count;
+  }
+  REQUIRE(count == static_cast<int>(items.size()));
+}
@@ -0,0 +1,189 @@
+/*
+ * intrusive_generation_list.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "../intrusive_generation_list.hpp"
+#include "doctest.h"
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace {
+struct G {
+  int i = 0;
+  pep::intrusive_generation_node n;
+};
+
+using gl = pep::intrusive_generation_list<G, &G::n>;
+
+std::vector<int> values(const gl& l) {
+  std::vector<int> out;
+  for (const G& g : l) {
+    out.push_back(g.i);
+  }
+  return out;
+}
+} // namespace
+
+TEST_CASE("generation list types") {
+  static_assert(sizeof(pep::intrusive_generation_node) == 4 * sizeof(void*));
+  static_assert((std::is_same<std::iterator_traits<gl::iterator>::iterator_category,
+                              std::bidirectional_iterator_tag>::value));
+}
+
+TEST_CASE("generation list") {
+  gl l;
+  gl other;
+  std::array<G, 5> arr;
+  for (int i = 0; i != 5; ++i) {
+    arr[i].i = i;
+  }
+  REQUIRE(l.empty());
+  REQUIRE(l.begin() == l.end());
+
+  l.push_back(arr[1]);
+  l.push_front(arr[0]);
+  l.push_back(arr[3]);
+  l.insert_after(&arr[1], arr[2]);
+  REQUIRE(values(l) == std::vector<int>{0, 1, 2, 3});
+  REQUIRE(l.size() == 4);
+  REQUIRE(&l.front() == &arr[0]);
+  REQUIRE(&l.back() == &arr[3]);
+  REQUIRE(arr[2].n.is_linked());
+  REQUIRE(!arr[4].n.is_linked());
+
+  l.erase(arr[2]);
+  REQUIRE(!arr[2].n.is_linked());
+  l.pop_front();
+  REQUIRE(values(l) == std::vector<int>{1, 3});
+  l.pop_back();
+  l.erase(l.begin());
+  REQUIRE(l.empty());
+  for (G& g : arr) {
+    REQUIRE(!g.n.is_linked());
+  }
+
+  SUBCASE("clear") {
+    for (G& g : arr) {
+      l.push_back(g);
+    }
+    std::uint64_t generation = l.generation();
+    l.clear();
+    REQUIRE(l.generation() == generation + 1);
+    REQUIRE(l.empty());
+    REQUIRE(l.size() == 0);
+    for (G& g : arr) {
+      REQUIRE(!g.n.is_linked());
+    }
+    // stale nodes can be linked again, in any order, and their old neighbours are left alone.
+    l.push_back(arr[3]);
+    l.push_back(arr[1]);
+    REQUIRE(values(l) == std::vector<int>{3, 1});
+    REQUIRE(arr[1].n.is_linked());
+    REQUIRE(!arr[2].n.is_linked());
+    l.erase(arr[3]);
+    REQUIRE(values(l) == std::vector<int>{1});
+    l.clear();
+    REQUIRE(!arr[1].n.is_linked());
+  }
+
+  SUBCASE("destroying elements") {
+    std::unique_ptr<G> a{new G{}};
+    std::unique_ptr<G> b{new G{}};
+    std::unique_ptr<G> c{new G{}};
+    a->i = 10;
+    b->i = 11;
+    c->i = 12;
+    l.push_back(*a);
+    l.push_back(*b);
+    l.push_back(*c);
+    // a linked element unlinks itself.
+    b.reset();
+    REQUIRE(values(l) == std::vector<int>{10, 12});
+    l.clear();
+    l.push_back(*c);
+    // a stale one doesn't touch its old neighbours.
+    a.reset();
+    REQUIRE(values(l) == std::vector<int>{12});
+    c->n.remove_from_list();
+    REQUIRE(l.empty());
+  }
+
+  SUBCASE("moving between lists") {
+    l.push_back(arr[0]);
+    l.push_back(arr[1]);
+    l.clear();
+    other.push_back(arr[1]);
+    other.push_back(arr[0]);
+    REQUIRE(values(other) == std::vector<int>{1, 0});
+    // clearing the first list doesn't affect elements now in the second.
+    l.clear();
+    REQUIRE(arr[0].n.is_linked());
+    REQUIRE(values(other) == std::vector<int>{1, 0});
+    other.clear();
+  }
+}
+
+TEST_CASE("generation list destroyed before its elements") {
+  std::array<G, 3> arr;
+  {
+    gl l;
+    for (G& g : arr) {
+      l.push_back(g);
+    }
+    REQUIRE(arr[0].n.is_linked());
+  }
+  for (G& g : arr) {
+    REQUIRE(!g.n.is_linked());
+  }
+  // the next list may well reuse the dead list's counter; the old stamps still don't match.
+  gl next;
+  REQUIRE(!arr[1].n.is_linked());
+  next.push_back(arr[1]);
+  REQUIRE(values(next) == std::vector<int>{0});
+  REQUIRE(arr[1].n.is_linked());
+  REQUIRE(!arr[0].n.is_linked());
+  next.erase(arr[1]);
+
+  // elements destroyed after their list don't touch it.
+  std::unique_ptr<G> late{new G{}};
+  {
+    gl l;
+    l.push_back(*late);
+  }
+  late.reset();
+}
+
+TEST_CASE("moving a generation node") {
+  gl l;
+  std::array<G, 3> arr;
+  for (int i = 0; i != 3; ++i) {
+    arr[i].i = i;
+    l.push_back(arr[i]);
+  }
+  G moved;
+  moved.i = 7;
+  moved.n = std::move(arr[1].n);
+  REQUIRE(moved.n.is_linked());
+  REQUIRE(!arr[1].n.is_linked());
+  REQUIRE(values(l) == std::vector<int>{0, 7, 2});
+
+  G constructed{0, std::move(moved.n)};
+  constructed.i = 8;
+  REQUIRE(!moved.n.is_linked());
+  REQUIRE(values(l) == std::vector<int>{0, 8, 2});
+
+  // assigning over a linked node unlinks it first.
+  arr[0].n = std::move(arr[2].n);
+  REQUIRE(values(l) == std::vector<int>{8, 0});
+  REQUIRE(&l.back() == &arr[0]);
+
+  // an unlinked source leaves the target unlinked.
+  G fresh;
+  fresh.n = std::move(arr[1].n);
+  REQUIRE(!fresh.n.is_linked());
+  l.clear();
+}
@@ -0,0 +1,153 @@
+/*
+ * intrusive_hash_table.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "../intrusive_hash_table.hpp"
+#include "doctest.h"
+#include <memory>
+#include <string>
+
+namespace {
+struct H {
+  int key;
+  std::string value;
+  pep::intrusive_hash_node n;
+};
+
+struct key_of_h {
+  int operator()(const H& h) const { return h.key; }
+};
+
+using table = pep::intrusive_hash_table<H, &H::n, key_of_h>;
+
+// every key collides.
+struct bad_hash {
+  std::size_t operator()(int) const { return 7; }
+};
+} // namespace
+
+TEST_CASE("hash table") {
+  table t;
+  REQUIRE(t.empty());
+  REQUIRE(t.find(1) == nullptr);
+  REQUIRE(t.erase(1) == nullptr);
+
+  H a{1, "a", {}}, b{2, "b", {}}, a2{1, "a2", {}};
+  REQUIRE(t.insert(a));
+  REQUIRE(t.insert(b));
+  REQUIRE(!t.insert(a2));
+  REQUIRE(t.size() == 2);
+  REQUIRE(t.find(1) == &a);
+  REQUIRE(t.find(2) == &b);
+  REQUIRE(t.find(3) == nullptr);
+
+  t.erase(a);
+  REQUIRE(t.find(1) == nullptr);
+  REQUIRE(t.insert(a2));
+  REQUIRE(t.find(1)->value == "a2");
+  REQUIRE(t.erase(2) == &b);
+  REQUIRE(t.size() == 1);
+  t.clear();
+  REQUIRE(t.empty());
+  REQUIRE(t.find(1) == nullptr);
+}
+
+TEST_CASE("hash table growth") {
+  constexpr int n = 5000;
+  std::unique_ptr<H[]> items{new H[n]};
+  table t;
+  for (int i = 0; i != n; ++i) {
+    items[i].key = i * 64;
+    REQUIRE(t.insert(items[i]));
+  }
+  REQUIRE(t.size() == n);
+  REQUIRE(t.bucket_count() >= n);
+  bool all_found = true;
+  for (int i = 0; i != n; ++i) {
+    all_found = all_found && t.find(i * 64) == &items[i];
+  }
+  REQUIRE(all_found);
+  for (int i = 0; i < n; i += 2) {
+    t.erase(items[i]);
+  }
+  REQUIRE(t.size() == n / 2);
+  bool odd_only = true;
+  for (int i = 0; i != n; ++i) {
+    odd_only = odd_only && (t.find(i * 64) != nullptr) == (i % 2 == 1);
+  }
+  REQUIRE(odd_only);
+  t.clear();
+}
+
+TEST_CASE("hash table collisions") {
+  pep::intrusive_hash_table<H, &H::n, key_of_h, bad_hash> t;
+  H arr[4] = {{0, "", {}}, {1, "", {}}, {2, "", {}}, {3, "", {}}};
+  for (H& h : arr) {
+    REQUIRE(t.insert(h));
+  }
+  for (H& h : arr) {
+    REQUIRE(t.find(h.key) == &h);
+  }
+  t.erase(arr[2]);
+  t.erase(arr[0]);
+  REQUIRE(t.find(0) == nullptr);
+  REQUIRE(t.find(2) == nullptr);
+  REQUIRE(t.find(1) == &arr[1]);
+  REQUIRE(t.find(3) == &arr[3]);
+  t.clear();
+}
+
+TEST_CASE("hash table incremental rehash") {
+  constexpr int n = 200;
+  std::unique_ptr<H[]> items{new H[n]};
+  for (int i = 0; i != n; ++i) {
+    items[i].key = i;
+  }
+  table t;
+  for (int i = 0; i != 16; ++i) {
+    t.insert(items[i]);
+  }
+  REQUIRE(t.bucket_count() == 16);
+  REQUIRE(!t.rehashing());
+  // crossing the load factor allocates the bigger array but only moves a few buckets.
+  t.insert(items[16]);
+  REQUIRE(t.bucket_count() == 32);
+  REQUIRE(t.rehashing());
+  bool all_found = true;
+  for (int i = 0; i != 17; ++i) {
+    all_found = all_found && t.find(i) == &items[i];
+  }
+  REQUIRE(all_found);
+
+  // erases during a rehash find the element in whichever array holds it.
+  t.erase(items[15]);
+  REQUIRE(t.erase(3) == &items[3]);
+  REQUIRE(t.find(15) == nullptr);
+  REQUIRE(t.find(3) == nullptr);
+
+  int grown = 1;
+  bool rehashed_between = true;
+  std::size_t buckets = t.bucket_count();
+  for (int i = 17; i != n; ++i) {
+    t.insert(items[i]);
+    if (t.bucket_count() != buckets) {
+      ++grown;
+      buckets = t.bucket_count();
+    } else if (t.size() == buckets) {
+      // a full array has always finished moving the previous one.
+      rehashed_between = rehashed_between && !t.rehashing();
+    }
+  }
+  REQUIRE(grown == 4);
+  REQUIRE(rehashed_between);
+  all_found = true;
+  for (int i = 0; i != n; ++i) {
+    all_found = all_found && (t.find(i) == &items[i]) == (i != 3 && i != 15);
+  }
+  REQUIRE(all_found);
+  t.clear();
+  REQUIRE(!t.rehashing());
+}
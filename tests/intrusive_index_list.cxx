@@ -0,0 +1,103 @@
+/*
+ * intrusive_index_list.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "../intrusive_index_list.hpp"
+#include "doctest.h"
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace {
+struct A {
+  int i;
+  pep::intrusive_index_node n;
+
+  explicit A(int v) : i(v) {}
+};
+
+using al = pep::intrusive_index_list<A, &A::n>;
+
+std::vector<int> values(const al& l) {
+  std::vector<int> out;
+  for (const A& a : l) {
+    out.push_back(a.i);
+  }
+  return out;
+}
+} // namespace
+
+TEST_CASE("index list types") {
+  static_assert(sizeof(pep::intrusive_index_node) == 8);
+  static_assert((std::is_same<al::value_type, A>::value));
+  static_assert((std::is_same<std::iterator_traits<al::iterator>::iterator_category,
+                              std::bidirectional_iterator_tag>::value));
+}
+
+TEST_CASE("index list") {
+  std::vector<A> arena;
+  for (int i = 0; i != 5; ++i) {
+    arena.emplace_back(i);
+  }
+  al l{arena.data()};
+  REQUIRE(l.empty());
+  REQUIRE(l.begin() == l.end());
+
+  l.push_back(arena[1]);
+  l.push_back(arena[2]);
+  l.push_front(arena[0]);
+  l.insert_after(arena[2], arena[4]);
+  l.insert_after(arena[2], arena[3]);
+  REQUIRE(l.size() == 5);
+  REQUIRE(values(l) == std::vector<int>{0, 1, 2, 3, 4});
+  REQUIRE(&l.front() == &arena[0]);
+  REQUIRE(&l.back() == &arena[4]);
+  REQUIRE(l.index_of(arena[3]) == 3);
+
+  SUBCASE("reverse iteration") {
+    auto it = l.end();
+    --it;
+    REQUIRE(it->i == 4);
+    it--;
+    REQUIRE(it->i == 3);
+    const al& cl = l;
+    al::const_iterator cit = l.begin();
+    REQUIRE(cit == cl.begin());
+  }
+  SUBCASE("erase") {
+    l.erase(arena[2]);
+    REQUIRE(!arena[2].n.is_linked());
+    l.erase(l.begin());
+    l.pop_back();
+    REQUIRE(values(l) == std::vector<int>{1, 3});
+    l.pop_front();
+    l.pop_front();
+    REQUIRE(l.empty());
+    REQUIRE(!arena[3].n.is_linked());
+  }
+  SUBCASE("arena reallocation") {
+    const A* old = arena.data();
+    arena.reserve(arena.capacity() * 4);
+    REQUIRE(arena.data() != old);
+    l.rebase(arena.data());
+    REQUIRE(values(l) == std::vector<int>{0, 1, 2, 3, 4});
+    l.erase(arena[1]);
+    REQUIRE(values(l) == std::vector<int>{0, 2, 3, 4});
+  }
+  SUBCASE("move") {
+    al l2 = std::move(l);
+    REQUIRE(l.empty());
+    REQUIRE(values(l2) == std::vector<int>{0, 1, 2, 3, 4});
+    l = std::move(l2);
+    REQUIRE(l2.empty());
+    REQUIRE(l.size() == 5);
+  }
+  SUBCASE("clear") {
+    l.clear();
+    REQUIRE(l.empty());
+    REQUIRE(std::none_of(arena.begin(), arena.end(), [](const A& a) { return a.n.is_linked(); }));
+  }
+}
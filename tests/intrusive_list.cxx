@@ -9,14 +9,18 @@
 #include "doctest.h"
 #include <algorithm>
 #include <array>
+#include <cstdio>
 #include <memory>
+#include <new>
 #include <numeric>
+#include <vector>
 
 struct S {
   int i;
   pep::intrusive_node n;
 
   friend bool operator==(const S& lhs, const S& rhs) { return &lhs == &rhs; }
+  friend bool operator<(const S& lhs, const S& rhs) { return lhs.i < rhs.i; }
 
   ~S() {}
 
@@ -188,7 +192,7 @@ TEST_CASE("non-empty list destructor") {
     sl_.push_front(b);
     sl_.push_front(c);
     REQUIRE(!sl_.empty());
-    // REQUIRE(sl_.size() == 3);
+    REQUIRE(sl_.size() == 3);
     REQUIRE(a.n.is_linked());
     REQUIRE(b.n.is_linked());
     REQUIRE(c.n.is_linked());
@@ -203,32 +207,32 @@ TEST_CASE("size, iterators") {
   const sl& csl = sl_;
   S a{1, {}}, b{2, {}}, c{3, {}};
   REQUIRE(sl_.is_empty());
-  // REQUIRE(sl_.size() == 0);
+  REQUIRE(sl_.size() == 0);
   REQUIRE(std::distance(sl_.begin(), sl_.end()) == 0);
   REQUIRE(std::distance(sl_.cbegin(), sl_.cend()) == 0);
   REQUIRE(sl_.begin() == sl_.end());
 
   REQUIRE(csl.is_empty());
-  // REQUIRE(csl.size() == 0);
+  REQUIRE(csl.size() == 0);
   REQUIRE(std::distance(csl.begin(), csl.end()) == 0);
   REQUIRE(std::distance(csl.cbegin(), csl.cend()) == 0);
   REQUIRE(csl.begin() == csl.end());
 
   sl_.push_front(a);
   REQUIRE(!sl_.is_empty());
-  // REQUIRE(sl_.size() == 1);
+  REQUIRE(sl_.size() == 1);
   REQUIRE(!csl.is_empty());
-  // REQUIRE(csl.size() == 1);
+  REQUIRE(csl.size() == 1);
   sl_.push_front(b);
   REQUIRE(!sl_.is_empty());
-  // REQUIRE(sl_.size() == 2);
+  REQUIRE(sl_.size() == 2);
   REQUIRE(!csl.is_empty());
-  // REQUIRE(csl.size() == 2);
+  REQUIRE(csl.size() == 2);
   sl_.push_front(c);
   REQUIRE(!sl_.is_empty());
-  // REQUIRE(sl_.size() == 3);
+  REQUIRE(sl_.size() == 3);
   REQUIRE(!csl.is_empty());
-  // REQUIRE(csl.size() == 3);
+  REQUIRE(csl.size() == 3);
 
   REQUIRE(std::distance(sl_.begin(), sl_.end()) == 3);
   REQUIRE(std::distance(sl_.cbegin(), sl_.cend()) == 3);
@@ -244,23 +248,23 @@ TEST_CASE("size, iterators") {
 
   sl_.pop_front();
   REQUIRE(!sl_.is_empty());
-  // REQUIRE(sl_.size() == 2);
+  REQUIRE(sl_.size() == 2);
   REQUIRE(!csl.is_empty());
-  // REQUIRE(csl.size() == 2);
+  REQUIRE(csl.size() == 2);
   sl_.pop_front();
   REQUIRE(!sl_.is_empty());
-  // REQUIRE(sl_.size() == 1);
+  REQUIRE(sl_.size() == 1);
   REQUIRE(!csl.is_empty());
-  // REQUIRE(csl.size() == 1);
+  REQUIRE(csl.size() == 1);
   sl_.pop_front();
   REQUIRE(sl_.is_empty());
-  // REQUIRE(sl_.size() == 0);
+  REQUIRE(sl_.size() == 0);
   REQUIRE(std::distance(sl_.begin(), sl_.end()) == 0);
   REQUIRE(std::distance(sl_.cbegin(), sl_.cend()) == 0);
   REQUIRE(sl_.begin() == sl_.end());
 
   REQUIRE(csl.is_empty());
-  // REQUIRE(csl.size() == 0);
+  REQUIRE(csl.size() == 0);
   REQUIRE(std::distance(csl.begin(), csl.end()) == 0);
   REQUIRE(std::distance(csl.cbegin(), csl.cend()) == 0);
   REQUIRE(csl.begin() == csl.end());
@@ -304,3 +308,690 @@ TEST_CASE("list move ctor"){
   REQUIRE(sl_.empty());
   REQUIRE(sl2.empty());
 }
+
+TEST_CASE("constant_time_size") {
+  using csl = pep::intrusive_list<S, &S::n, pep::constant_time_size<true>>;
+  static_assert(sizeof(sl) == sizeof(pep::details::ilist_base));
+  static_assert(sizeof(pep::intrusive_list<S, &S::n, pep::constant_time_size<false>>) ==
+                sizeof(pep::details::ilist_base));
+  static_assert(sizeof(csl) == sizeof(pep::details::ilist_base) + sizeof(std::size_t));
+
+  S a{1, {}}, b{2, {}}, c{3, {}}, d{4, {}};
+  csl l;
+  REQUIRE(l.size() == 0);
+  l.push_back(a);
+  l.push_front(b);
+  l.insert_after(&a, c);
+  l.insert_after(&b, d);
+  REQUIRE(l.size() == 4);
+  l.erase(d);
+  REQUIRE(l.size() == 3);
+  l.pop_front();
+  REQUIRE(l.size() == 2);
+  l.pop_back();
+  REQUIRE(l.size() == 1);
+
+  csl l2 = std::move(l);
+  REQUIRE(l.size() == 0);
+  REQUIRE(l2.size() == 1);
+  l2.push_back(b);
+  l = std::move(l2);
+  REQUIRE(l.size() == 2);
+  REQUIRE(l2.size() == 0);
+
+  l.clear();
+  REQUIRE(l.size() == 0);
+  REQUIRE(l.empty());
+}
+
+TEST_CASE("circular_layout") {
+  using cl = pep::intrusive_list<S, &S::n, pep::circular_layout>;
+  static_assert(sizeof(cl) == 2 * sizeof(void*));
+  static_assert(sizeof(sl) == 4 * sizeof(void*));
+  static_assert(sizeof(pep::intrusive_list<S, &S::n, pep::circular_layout,
+                                           pep::constant_time_size<true>>) == 3 * sizeof(void*));
+
+  S a{1, {}}, b{2, {}}, c{3, {}};
+  cl l;
+  REQUIRE(l.empty());
+  REQUIRE(l.begin() == l.end());
+  l.push_back(a);
+  l.push_back(b);
+  l.push_front(c);
+  REQUIRE(l.size() == 3);
+  REQUIRE(&l.front() == &c);
+  REQUIRE(&l.back() == &b);
+  REQUIRE(&*--l.end() == &b);
+  REQUIRE(std::accumulate(l.begin(), l.end(), 0, [](int x, const S& s) { return x + s.i; }) == 6);
+
+  l.erase(a);
+  REQUIRE(!a.n.is_linked());
+  REQUIRE(l.size() == 2);
+  l.insert_after(&c, a);
+  REQUIRE(&*++l.begin() == &a);
+  l.pop_front();
+  l.pop_back();
+  REQUIRE(&l.front() == &a);
+  REQUIRE(&l.back() == &a);
+
+  SUBCASE("moved node") {
+    S d{std::move(a)};
+    REQUIRE(!a.n.is_linked());
+    REQUIRE(&l.front() == &d);
+    REQUIRE(&l.back() == &d);
+  }
+  SUBCASE("destroyed node") {
+    {
+      S d;
+      l.push_back(d);
+      REQUIRE(l.size() == 2);
+    }
+    REQUIRE(l.size() == 1);
+    l.pop_back();
+    REQUIRE(l.empty());
+  }
+  SUBCASE("moved list") {
+    l.push_back(b);
+    cl l2 = std::move(l);
+    REQUIRE(l.empty());
+    REQUIRE(&l2.front() == &a);
+    REQUIRE(&l2.back() == &b);
+    l = std::move(l2);
+    REQUIRE(l2.empty());
+    REQUIRE(l.size() == 2);
+  }
+  SUBCASE("list destructor") {
+    {
+      cl l2;
+      l2.push_back(b);
+      l2.push_back(c);
+    }
+    REQUIRE(!b.n.is_linked());
+    REQUIRE(!c.n.is_linked());
+  }
+}
+
+namespace {
+template <typename L>
+std::vector<int> values(const L& l) {
+  std::vector<int> out;
+  for (const S& s : l) {
+    out.push_back(s.i);
+  }
+  return out;
+}
+
+using circular_sl = pep::intrusive_list<S, &S::n, pep::circular_layout>;
+using counted_sl = pep::intrusive_list<S, &S::n, pep::constant_time_size<true>>;
+} // namespace
+
+TEST_CASE_TEMPLATE("splice", L, doctest::Types<sl, circular_sl, counted_sl>) {
+  std::array<S, 6> arr;
+  for (int i = 0; i != 6; ++i) {
+    arr[i].i = i;
+  }
+  L a, b;
+  a.push_back(arr[0]);
+  a.push_back(arr[1]);
+  a.push_back(arr[2]);
+  b.push_back(arr[3]);
+  b.push_back(arr[4]);
+  b.push_back(arr[5]);
+
+  SUBCASE("whole list") {
+    a.splice(++a.begin(), b);
+    REQUIRE(b.empty());
+    REQUIRE(b.size() == 0);
+    REQUIRE(a.size() == 6);
+    REQUIRE(values(a) == std::vector<int>{0, 3, 4, 5, 1, 2});
+    b.splice(b.end(), a);
+    REQUIRE(a.empty());
+    REQUIRE(values(b) == std::vector<int>{0, 3, 4, 5, 1, 2});
+    b.splice(b.begin(), a);
+    REQUIRE(b.size() == 6);
+  }
+  SUBCASE("range") {
+    auto first = ++b.begin();
+    a.splice(a.end(), b, first, b.end());
+    REQUIRE(values(a) == std::vector<int>{0, 1, 2, 4, 5});
+    REQUIRE(values(b) == std::vector<int>{3});
+    REQUIRE(a.size() == 5);
+    REQUIRE(b.size() == 1);
+    a.splice(a.begin(), b, b.begin(), b.begin());
+    REQUIRE(a.size() == 5);
+  }
+  SUBCASE("range within a list") {
+    auto first = ++a.begin();
+    a.splice(a.begin(), a, first, a.end());
+    REQUIRE(values(a) == std::vector<int>{1, 2, 0});
+    a.splice(a.end(), a, a.begin(), ++a.begin());
+    REQUIRE(values(a) == std::vector<int>{2, 0, 1});
+    // no-op, the range already ends at `pos`.
+    a.splice(a.end(), a, ++a.begin(), a.end());
+    REQUIRE(values(a) == std::vector<int>{2, 0, 1});
+    REQUIRE(a.size() == 3);
+  }
+  SUBCASE("single element") {
+    a.splice(a.end(), b, ++b.begin());
+    REQUIRE(values(a) == std::vector<int>{0, 1, 2, 4});
+    REQUIRE(values(b) == std::vector<int>{3, 5});
+    REQUIRE(a.size() == 4);
+    REQUIRE(b.size() == 2);
+    a.splice(a.begin(), a, --a.end());
+    REQUIRE(values(a) == std::vector<int>{4, 0, 1, 2});
+  }
+  SUBCASE("split_after") {
+    L tail = a.split_after(a.begin());
+    REQUIRE(values(a) == std::vector<int>{0});
+    REQUIRE(values(tail) == std::vector<int>{1, 2});
+    REQUIRE(a.size() == 1);
+    REQUIRE(tail.size() == 2);
+    L none = tail.split_after(--tail.end());
+    REQUIRE(none.empty());
+    REQUIRE(tail.size() == 2);
+  }
+}
+
+TEST_CASE_TEMPLATE("move_to_back", L, doctest::Types<sl, circular_sl, counted_sl>) {
+  std::array<S, 4> arr;
+  L l;
+  for (int i = 0; i != 4; ++i) {
+    arr[i].i = i;
+    l.push_back(arr[i]);
+  }
+  l.move_to_back(arr[1]);
+  REQUIRE(values(l) == std::vector<int>{0, 2, 3, 1});
+  l.move_to_back(arr[1]);
+  REQUIRE(values(l) == std::vector<int>{0, 2, 3, 1});
+  l.move_to_back(arr[0]);
+  REQUIRE(values(l) == std::vector<int>{2, 3, 1, 0});
+  l.move_to_front(arr[1]);
+  REQUIRE(values(l) == std::vector<int>{1, 2, 3, 0});
+  l.move_to_front(arr[1]);
+  REQUIRE(values(l) == std::vector<int>{1, 2, 3, 0});
+  REQUIRE(l.size() == 4);
+  REQUIRE(&l.back() == &arr[0]);
+}
+
+TEST_CASE_TEMPLATE("sort", L, doctest::Types<sl, circular_sl, counted_sl>) {
+  std::array<S, 64> arr;
+  for (std::size_t i = 0; i != arr.size(); ++i) {
+    // lots of duplicate keys so stability is observable.
+    arr[i].i = static_cast<int>((i * 37) % 11);
+  }
+  L l;
+  auto by_key = [](const S& a, const S& b) { return a.i < b.i; };
+
+  SUBCASE("empty and single") {
+    l.sort(by_key);
+    REQUIRE(l.empty());
+    l.push_back(arr[0]);
+    l.sort(by_key);
+    REQUIRE(&l.front() == &arr[0]);
+    REQUIRE(&l.back() == &arr[0]);
+  }
+  SUBCASE("stable") {
+    for (S& s : arr) {
+      l.push_back(s);
+    }
+    l.sort(by_key);
+    REQUIRE(l.size() == arr.size());
+    std::vector<S*> expected;
+    for (S& s : arr) {
+      expected.push_back(&s);
+    }
+    std::stable_sort(expected.begin(), expected.end(),
+                     [](const S* a, const S* b) { return a->i < b->i; });
+    std::vector<S*> actual;
+    for (S& s : l) {
+      actual.push_back(&s);
+    }
+    REQUIRE(actual == expected);
+    // prev links are rebuilt too.
+    std::vector<S*> reversed;
+    for (auto it = l.end(); it != l.begin();) {
+      --it;
+      reversed.push_back(&*it);
+    }
+    std::reverse(reversed.begin(), reversed.end());
+    REQUIRE(reversed == expected);
+    REQUIRE(&l.back() == expected.back());
+  }
+  SUBCASE("default comparison") {
+    for (S& s : arr) {
+      l.push_front(s);
+    }
+    std::vector<S*> expected;
+    for (S& s : l) {
+      expected.push_back(&s);
+    }
+    std::stable_sort(expected.begin(), expected.end(),
+                     [](const S* a, const S* b) { return *a < *b; });
+    l.sort();
+    std::vector<S*> actual;
+    for (S& s : l) {
+      actual.push_back(&s);
+    }
+    REQUIRE(actual == expected);
+  }
+}
+
+TEST_CASE_TEMPLATE("merge", L, doctest::Types<sl, circular_sl, counted_sl>) {
+  std::array<S, 10> arr;
+  const int keys[] = {1, 3, 3, 5, 9, 0, 3, 4, 10, 11};
+  for (std::size_t i = 0; i != arr.size(); ++i) {
+    arr[i].i = keys[i];
+  }
+  L a, b;
+  for (std::size_t i = 0; i != 5; ++i) {
+    a.push_back(arr[i]);
+    b.push_back(arr[i + 5]);
+  }
+  auto by_key = [](const S& x, const S& y) { return x.i < y.i; };
+  a.merge(b, by_key);
+  REQUIRE(b.empty());
+  REQUIRE(b.size() == 0);
+  REQUIRE(a.size() == 10);
+  REQUIRE(values(a) == std::vector<int>{0, 1, 3, 3, 3, 4, 5, 9, 10, 11});
+  // ties keep this list's elements first.
+  auto it = ++ ++a.begin();
+  REQUIRE(&*it == &arr[1]);
+  REQUIRE(&*++it == &arr[2]);
+  REQUIRE(&*++it == &arr[6]);
+
+  a.merge(b, by_key);
+  REQUIRE(a.size() == 10);
+  b.merge(a, by_key);
+  REQUIRE(a.empty());
+  REQUIRE(values(b) == std::vector<int>{0, 1, 3, 3, 3, 4, 5, 9, 10, 11});
+}
+
+TEST_CASE_TEMPLATE("merge with operator<", L, doctest::Types<sl, circular_sl, counted_sl>) {
+  std::array<S, 8> arr;
+  const int keys[] = {2, 4, 4, 8, 1, 4, 6, 9};
+  for (std::size_t i = 0; i != arr.size(); ++i) {
+    arr[i].i = keys[i];
+  }
+  L a, b;
+  for (std::size_t i = 0; i != 4; ++i) {
+    a.push_back(arr[i]);
+    b.push_back(arr[i + 4]);
+  }
+  a.merge(b);
+  REQUIRE(b.empty());
+  REQUIRE(a.size() == 8);
+  REQUIRE(values(a) == std::vector<int>{1, 2, 4, 4, 4, 6, 8, 9});
+  // ties keep this list's elements first.
+  auto it = ++ ++a.begin();
+  REQUIRE(&*it == &arr[1]);
+  REQUIRE(&*++it == &arr[2]);
+  REQUIRE(&*++it == &arr[5]);
+}
+
+namespace {
+struct idle_tag;
+struct conn_tag;
+
+struct connection : pep::intrusive_base_node<idle_tag>, pep::intrusive_base_node<conn_tag> {
+  int id = 0;
+  pep::intrusive_node extra;
+};
+
+using idle_list = pep::intrusive_base_list<connection, idle_tag>;
+using conn_list = pep::intrusive_base_list<connection, conn_tag, pep::circular_layout>;
+using extra_list = pep::intrusive_list<connection, &connection::extra>;
+
+template <typename L>
+std::vector<int> ids(const L& l) {
+  std::vector<int> out;
+  for (const connection& c : l) {
+    out.push_back(c.id);
+  }
+  return out;
+}
+} // namespace
+
+TEST_CASE("base hooks") {
+  std::vector<connection> cs(4);
+  for (int i = 0; i != 4; ++i) {
+    cs[i].id = i;
+  }
+  idle_list idle;
+  conn_list conns;
+  extra_list extra;
+  for (connection& c : cs) {
+    conns.push_back(c);
+    extra.push_front(c);
+  }
+  idle.push_back(cs[2]);
+  idle.push_back(cs[0]);
+  REQUIRE(ids(conns) == std::vector<int>{0, 1, 2, 3});
+  REQUIRE(ids(idle) == std::vector<int>{2, 0});
+  REQUIRE(ids(extra) == std::vector<int>{3, 2, 1, 0});
+  REQUIRE(&idle.front() == &cs[2]);
+  REQUIRE(&conns.back() == &cs[3]);
+
+  conns.erase(cs[2]);
+  REQUIRE(ids(conns) == std::vector<int>{0, 1, 3});
+  REQUIRE(ids(idle) == std::vector<int>{2, 0});
+  REQUIRE(static_cast<pep::intrusive_base_node<idle_tag>&>(cs[2]).is_linked());
+  REQUIRE(!static_cast<pep::intrusive_base_node<conn_tag>&>(cs[2]).is_linked());
+
+  idle.sort([](const connection& a, const connection& b) { return a.id < b.id; });
+  REQUIRE(ids(idle) == std::vector<int>{0, 2});
+  {
+    connection temp;
+    temp.id = 9;
+    idle.push_back(temp);
+    conns.push_front(temp);
+  }
+  REQUIRE(ids(idle) == std::vector<int>{0, 2});
+  REQUIRE(ids(conns) == std::vector<int>{0, 1, 3});
+}
+
+// The hook offset must fold to a constant on every ABI, so that dereferencing a list iterator is a
+// single subtraction. Only checkable in optimized builds.
+#if defined(__OPTIMIZE__) && defined(NDEBUG) && (defined(__GNUC__) || defined(__clang__))
+namespace {
+[[gnu::noinline]] S& deref(sl::iterator it) { return *it; }
+} // namespace
+
+TEST_CASE("hook offset is a compile-time constant") {
+  std::ptrdiff_t offset = pep::details::member_offset<S, pep::intrusive_node, &S::n>();
+  bool folded = __builtin_constant_p(offset);
+  REQUIRE(folded);
+  S s;
+  REQUIRE(offset == reinterpret_cast<char*>(&s.n) - reinterpret_cast<char*>(&s));
+  REQUIRE(&deref(sl::iterator{&s.n}) == &s);
+
+#  if defined(__x86_64__) && defined(__linux__)
+  // deref's machine code: an optional endbr64, then `lea rax, [rdi - offset]` or
+  // `mov rax, rdi; sub rax, offset`, then ret.
+  const unsigned char* code = reinterpret_cast<const unsigned char*>(&deref);
+  const unsigned char endbr64[] = {0xf3, 0x0f, 0x1e, 0xfa};
+  if (std::equal(endbr64, endbr64 + 4, code)) {
+    code += 4;
+  }
+  auto disp8 = static_cast<unsigned char>(-offset);
+  const unsigned char lea[] = {0x48, 0x8d, 0x47, disp8, 0xc3};
+  const unsigned char mov_sub[] = {0x48, 0x89, 0xf8, 0x48, 0x83, 0xe8,
+                                   static_cast<unsigned char>(offset), 0xc3};
+  bool single_subtract =
+    std::equal(lea, lea + sizeof(lea), code) || std::equal(mov_sub, mov_sub + sizeof(mov_sub), code);
+  REQUIRE(single_subtract);
+#  endif
+}
+#endif
+
+namespace {
+template <pep::link_mode Mode>
+struct M {
+  int i = 0;
+  pep::basic_intrusive_node<Mode> n;
+};
+
+template <pep::link_mode Mode, typename... Options>
+struct mode_list {
+  using value_type = M<Mode>;
+  using type = pep::intrusive_list<M<Mode>, &M<Mode>::n, Options...>;
+};
+
+template <typename L>
+std::vector<int> mode_values(const L& l) {
+  std::vector<int> out;
+  for (const auto& m : l) {
+    out.push_back(m.i);
+  }
+  return out;
+}
+} // namespace
+
+TEST_CASE_TEMPLATE("link modes", P,
+                   doctest::Types<mode_list<pep::link_mode::normal>,
+                                  mode_list<pep::link_mode::normal, pep::circular_layout>,
+                                  mode_list<pep::link_mode::normal, pep::constant_time_size<true>>,
+                                  mode_list<pep::link_mode::safe>,
+                                  mode_list<pep::link_mode::safe, pep::circular_layout>>) {
+  using L = typename P::type;
+  using V = typename P::value_type;
+  static_assert(sizeof(V{}.n) == 2 * sizeof(void*));
+  std::array<V, 5> arr;
+  for (int i = 0; i != 5; ++i) {
+    arr[i].i = i;
+  }
+  L l;
+  for (V& v : arr) {
+    l.push_back(v);
+  }
+  REQUIRE(mode_values(l) == std::vector<int>{0, 1, 2, 3, 4});
+  l.erase(arr[2]);
+  l.pop_front();
+  l.pop_back();
+  REQUIRE(mode_values(l) == std::vector<int>{1, 3});
+  if (L::mode == pep::link_mode::safe) {
+    REQUIRE(!arr[2].n.is_linked());
+    REQUIRE(!arr[0].n.is_linked());
+  }
+  // erased nodes can be linked again whatever their mode.
+  l.push_front(arr[2]);
+  l.insert_after(&arr[1], arr[0]);
+  l.push_back(arr[4]);
+  REQUIRE(mode_values(l) == std::vector<int>{2, 1, 0, 3, 4});
+  REQUIRE(l.size() == 5);
+
+  // moving a node: a safe node hands its position over, a normal one starts out unlinked.
+  V moved;
+  moved.i = 7;
+  moved.n = std::move(arr[3].n);
+  if (L::mode == pep::link_mode::safe) {
+    REQUIRE(mode_values(l) == std::vector<int>{2, 1, 0, 7, 4});
+    l.erase(moved);
+  } else {
+    l.erase(arr[3]);
+  }
+  REQUIRE(mode_values(l) == std::vector<int>{2, 1, 0, 4});
+
+  L other{std::move(l)};
+  REQUIRE(l.empty());
+  REQUIRE(other.size() == 4);
+  other.clear();
+  REQUIRE(other.empty());
+  REQUIRE(other.size() == 0);
+  if (L::mode == pep::link_mode::safe) {
+    for (V& v : arr) {
+      REQUIRE(!v.n.is_linked());
+    }
+  }
+  other.push_back(arr[1]);
+  REQUIRE(mode_values(other) == std::vector<int>{1});
+  // destroying the list unlinks arr[1] before the array goes away; in normal mode nothing is
+  // touched at all.
+}
+
+TEST_CASE("for_each_prefetch") {
+  std::array<S, 20> arr;
+  sl l;
+  for (int i = 0; i != 20; ++i) {
+    arr[i].i = i;
+    l.push_back(arr[i]);
+  }
+  std::vector<int> expected(20);
+  std::iota(expected.begin(), expected.end(), 0);
+  for (std::size_t distance : {0, 1, 4, 19, 20, 64}) {
+    std::vector<int> seen;
+    pep::for_each_prefetch(l, [&](S& s) { seen.push_back(s.i); }, distance);
+    REQUIRE(seen == expected);
+  }
+  std::vector<int> seen;
+  const sl& cl = l;
+  pep::for_each_prefetch(cl, [&](const S& s) { seen.push_back(s.i); }, 3, offsetof(S, i));
+  REQUIRE(seen == expected);
+  l.clear();
+  pep::for_each_prefetch(l, [](S&) { FAIL("empty list"); });
+}
+
+TEST_CASE_TEMPLATE("range insertion", L, doctest::Types<sl, circular_sl, counted_sl>) {
+  std::array<S, 8> arr;
+  for (int i = 0; i != 8; ++i) {
+    arr[i].i = i;
+  }
+  L l;
+  l.push_back_range(arr.begin(), arr.begin());
+  REQUIRE(l.empty());
+  l.push_back_range(arr.begin(), arr.begin() + 3);
+  REQUIRE(values(l) == std::vector<int>{0, 1, 2});
+
+  std::vector<S*> ptrs{&arr[5], &arr[4], &arr[3]};
+  l.push_back_range(ptrs.begin(), ptrs.end());
+  REQUIRE(values(l) == std::vector<int>{0, 1, 2, 5, 4, 3});
+
+  l.insert_after(l.begin(), arr.begin() + 6, arr.end());
+  REQUIRE(values(l) == std::vector<int>{0, 6, 7, 1, 2, 5, 4, 3});
+  REQUIRE(l.size() == 8);
+  REQUIRE(&l.back() == &arr[3]);
+
+  l.erase(arr[7]);
+  l.pop_back();
+  REQUIRE(values(l) == std::vector<int>{0, 6, 1, 2, 5, 4});
+  std::vector<int> backwards;
+  for (auto it = l.end(); it != l.begin();) {
+    --it;
+    backwards.push_back(it->i);
+  }
+  REQUIRE(backwards == std::vector<int>{4, 5, 2, 1, 6, 0});
+}
+
+TEST_CASE_TEMPLATE("remove_if and erase_many", L, doctest::Types<sl, circular_sl, counted_sl>) {
+  std::array<S, 10> arr;
+  for (int i = 0; i != 10; ++i) {
+    arr[i].i = i;
+  }
+  L l;
+  l.push_back_range(arr.begin(), arr.end());
+  REQUIRE(l.remove_if([](const S&) { return false; }) == 0);
+  // runs at the front, in the middle and at the back.
+  REQUIRE(l.remove_if([](const S& s) { return s.i < 2 || s.i == 4 || s.i == 5 || s.i == 9; }) ==
+          5);
+  REQUIRE(values(l) == std::vector<int>{2, 3, 6, 7, 8});
+  REQUIRE(l.size() == 5);
+  REQUIRE(!arr[0].n.is_linked());
+  REQUIRE(!arr[9].n.is_linked());
+  REQUIRE(&l.back() == &arr[8]);
+
+  std::vector<S*> victims{&arr[7], &arr[2], &arr[6], &arr[3]};
+  REQUIRE(l.erase_many(victims.begin(), victims.end()) == 4);
+  REQUIRE(values(l) == std::vector<int>{8});
+  REQUIRE(l.size() == 1);
+  for (S* v : victims) {
+    REQUIRE(!v->n.is_linked());
+  }
+  REQUIRE(l.erase_many(victims.begin(), victims.begin()) == 0);
+  REQUIRE(l.erase_many(arr.begin() + 8, arr.begin() + 9) == 1);
+  REQUIRE(l.empty());
+
+  l.push_back_range(arr.begin(), arr.end());
+  REQUIRE(l.remove_if([](const S&) { return true; }) == 10);
+  REQUIRE(l.empty());
+  REQUIRE(l.size() == 0);
+  l.push_back(arr[3]);
+  REQUIRE(values(l) == std::vector<int>{3});
+  l.clear();
+
+  std::vector<S*> owned;
+  for (int i = 0; i != 6; ++i) {
+    owned.push_back(new S{});
+    owned.back()->i = i;
+  }
+  l.push_back_range(owned.begin(), owned.end());
+  std::vector<int> disposed;
+  REQUIRE(l.remove_if_and_dispose([](const S& s) { return s.i % 2 == 1; },
+                                  [&](S& s) {
+                                    disposed.push_back(s.i);
+                                    delete &s;
+                                  }) == 3);
+  REQUIRE(disposed == std::vector<int>{1, 3, 5});
+  REQUIRE(values(l) == std::vector<int>{0, 2, 4});
+  l.remove_if_and_dispose([](const S&) { return true; }, [](S& s) { delete &s; });
+  REQUIRE(l.empty());
+}
+
+TEST_CASE_TEMPLATE("remove_if across link modes", P,
+                   doctest::Types<mode_list<pep::link_mode::normal>,
+                                  mode_list<pep::link_mode::normal, pep::constant_time_size<true>>,
+                                  mode_list<pep::link_mode::safe, pep::circular_layout>>) {
+  using L = typename P::type;
+  using V = typename P::value_type;
+  std::array<V, 6> arr;
+  for (int i = 0; i != 6; ++i) {
+    arr[i].i = i;
+  }
+  L l;
+  l.push_back_range(arr.begin(), arr.end());
+  REQUIRE(l.remove_if([](const V& v) { return v.i % 3 != 0; }) == 4);
+  REQUIRE(mode_values(l) == std::vector<int>{0, 3});
+  std::vector<V*> victims{&arr[3]};
+  REQUIRE(l.erase_many(victims.begin(), victims.end()) == 1);
+  REQUIRE(mode_values(l) == std::vector<int>{0});
+  REQUIRE(l.size() == 1);
+  // removed nodes can be linked again whatever their mode.
+  l.push_back(arr[4]);
+  l.push_front(arr[3]);
+  REQUIRE(mode_values(l) == std::vector<int>{3, 0, 4});
+  l.clear();
+}
+
+TEST_CASE_TEMPLATE("clear_and_dispose and forget", L, doctest::Types<sl, circular_sl, counted_sl>) {
+  L l;
+  for (int i = 0; i != 5; ++i) {
+    S* s = new S{};
+    s->i = i;
+    l.push_back(*s);
+  }
+  std::vector<int> disposed;
+  l.clear_and_dispose([&](S& s) {
+    REQUIRE(!s.n.is_linked());
+    disposed.push_back(s.i);
+    delete &s;
+  });
+  REQUIRE(disposed == std::vector<int>{0, 1, 2, 3, 4});
+  REQUIRE(l.empty());
+  REQUIRE(l.size() == 0);
+  l.clear_and_dispose([](S&) { FAIL("nothing to dispose of"); });
+
+  std::array<S, 4> arr;
+  l.push_back_range(arr.begin(), arr.end());
+  l.clear();
+  for (S& s : arr) {
+    REQUIRE(!s.n.is_linked());
+  }
+
+  // forgotten auto_unlink nodes keep their links, they are released below without destruction.
+  using storage = std::aligned_storage_t<sizeof(S), alignof(S)>;
+  std::unique_ptr<storage[]> arena{new storage[3]};
+  for (int i = 0; i != 3; ++i) {
+    l.push_back(*new (&arena[i]) S{});
+  }
+  REQUIRE(l.size() == 3);
+  l.forget();
+  REQUIRE(l.empty());
+  REQUIRE(l.size() == 0);
+  REQUIRE(l.begin() == l.end());
+  l.push_back(arr[1]);
+  REQUIRE(&l.front() == &arr[1]);
+  l.clear();
+}
+
+TEST_CASE("forget in normal mode") {
+  using V = M<pep::link_mode::normal>;
+  std::array<V, 3> arr;
+  pep::intrusive_list<V, &V::n, pep::constant_time_size<true>> l;
+  l.push_back_range(arr.begin(), arr.end());
+  l.forget();
+  REQUIRE(l.empty());
+  REQUIRE(l.size() == 0);
+  // normal mode nodes can be linked again after being forgotten.
+  l.push_back(arr[2]);
+  l.push_back(arr[0]);
+  REQUIRE(l.size() == 2);
+  REQUIRE(&l.back() == &arr[0]);
+}
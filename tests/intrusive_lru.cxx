@@ -0,0 +1,127 @@
+/*
+ * intrusive_lru.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "../intrusive_lru.hpp"
+#include "doctest.h"
+#include <array>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+struct E {
+  int key;
+  int hits = 0;
+  pep::intrusive_lru_node n;
+};
+
+struct key_of_e {
+  int operator()(const E& e) const { return e.key; }
+};
+
+using lru = pep::intrusive_lru<E, &E::n, key_of_e>;
+using sharded = pep::intrusive_sharded_lru<E, &E::n, key_of_e, 4>;
+} // namespace
+
+TEST_CASE("lru") {
+  std::array<E, 5> arr;
+  for (int i = 0; i != 5; ++i) {
+    arr[i].key = i;
+  }
+  lru c;
+  REQUIRE(c.empty());
+  REQUIRE(!c.evict([](E&) {}));
+  for (E& e : arr) {
+    REQUIRE(c.insert(e));
+  }
+  E dup;
+  dup.key = 3;
+  REQUIRE(!c.insert(dup));
+  REQUIRE(c.size() == 5);
+  REQUIRE(&c.oldest() == &arr[0]);
+  REQUIRE(&c.newest() == &arr[4]);
+
+  // find doesn't touch, get does.
+  REQUIRE(c.find(0) == &arr[0]);
+  REQUIRE(&c.oldest() == &arr[0]);
+  REQUIRE(c.get(0) == &arr[0]);
+  REQUIRE(&c.newest() == &arr[0]);
+  c.touch(arr[1]);
+  REQUIRE(c.get(42) == nullptr);
+
+  std::vector<int> evicted;
+  auto dispose = [&](E& e) { evicted.push_back(e.key); };
+  REQUIRE(c.evict(dispose));
+  REQUIRE(evicted == std::vector<int>{2});
+  REQUIRE(c.find(2) == nullptr);
+
+  REQUIRE(c.erase(3) == &arr[3]);
+  c.erase(arr[0]);
+  REQUIRE(c.size() == 2);
+  c.evict_to(0, dispose);
+  REQUIRE(evicted == std::vector<int>{2, 4, 1});
+  REQUIRE(c.empty());
+
+  // evicted elements can come back.
+  REQUIRE(c.insert(arr[2]));
+  REQUIRE(c.get(2) == &arr[2]);
+  c.clear();
+  REQUIRE(c.find(2) == nullptr);
+}
+
+TEST_CASE("sharded lru") {
+  constexpr int n = 64;
+  std::unique_ptr<E[]> items{new E[n]};
+  sharded c{16};
+  REQUIRE(c.shard_count() == 4);
+  REQUIRE(c.shard_capacity() == 4);
+
+  int disposed = 0;
+  auto dispose = [&](E&) { ++disposed; };
+  for (int i = 0; i != n; ++i) {
+    items[i].key = i;
+    REQUIRE(c.insert(items[i], dispose));
+  }
+  REQUIRE(c.size() <= 16);
+  REQUIRE(disposed == n - static_cast<int>(c.size()));
+  // the newest key always survives in its shard.
+  REQUIRE(c.visit(n - 1, [](E& e) { ++e.hits; }));
+  REQUIRE(items[n - 1].hits == 1);
+  REQUIRE(c.erase(n - 1) == &items[n - 1]);
+  REQUIRE(!c.visit(n - 1, [](E&) {}));
+  c.clear(dispose);
+  REQUIRE(c.size() == 0);
+  REQUIRE(disposed == n - 1);
+}
+
+TEST_CASE("sharded lru threads") {
+  constexpr int threads = 4;
+  constexpr int per_thread = 2000;
+  std::unique_ptr<E[]> items{new E[threads * per_thread]};
+  sharded c{256};
+  std::vector<std::thread> workers;
+  std::array<int, threads> disposed{};
+  for (int t = 0; t != threads; ++t) {
+    workers.emplace_back([&, t] {
+      for (int i = 0; i != per_thread; ++i) {
+        E& e = items[t * per_thread + i];
+        e.key = t * per_thread + i;
+        c.insert(e, [&](E&) { ++disposed[t]; });
+        c.visit(e.key, [](E& found) { ++found.hits; });
+      }
+    });
+  }
+  for (std::thread& w : workers) {
+    w.join();
+  }
+  int total = 0;
+  for (int d : disposed) {
+    total += d;
+  }
+  REQUIRE(total + static_cast<int>(c.size()) == threads * per_thread);
+  c.clear([](E&) {});
+}
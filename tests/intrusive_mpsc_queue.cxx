@@ -0,0 +1,132 @@
+/*
+ * intrusive_mpsc_queue.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "../intrusive_mpsc_queue.hpp"
+#include "doctest.h"
+#include <array>
+#include <thread>
+#include <vector>
+
+namespace {
+struct M {
+  int producer;
+  int seq;
+  pep::intrusive_mpsc_node n;
+};
+
+using mq = pep::intrusive_mpsc_queue<M, &M::n>;
+} // namespace
+
+TEST_CASE("mpsc queue single thread") {
+  std::array<M, 6> arr{};
+  for (int i = 0; i != 6; ++i) {
+    arr[i].seq = i;
+  }
+  mq q;
+  REQUIRE(q.empty());
+  REQUIRE(q.pop() == nullptr);
+
+  q.push(arr[0]);
+  REQUIRE(!q.empty());
+  q.push(arr[1]);
+  REQUIRE(q.pop() == &arr[0]);
+  REQUIRE(q.pop() == &arr[1]);
+  REQUIRE(q.pop() == nullptr);
+  REQUIRE(q.empty());
+
+  SUBCASE("push_chain") {
+    arr[2].n.set_next(&arr[3].n);
+    arr[3].n.set_next(&arr[4].n);
+    q.push(arr[1]);
+    q.push_chain(arr[2], arr[4]);
+    q.push(arr[5]);
+    for (int i = 1; i != 6; ++i) {
+      REQUIRE(q.pop() == &arr[i]);
+    }
+    REQUIRE(q.pop() == nullptr);
+  }
+  SUBCASE("push_range") {
+    std::vector<M*> batch{&arr[3], &arr[0], &arr[5]};
+    struct deref {
+      std::vector<M*>::iterator it;
+      M& operator*() const { return **it; }
+      deref& operator++() {
+        ++it;
+        return *this;
+      }
+      bool operator==(const deref& rhs) const { return it == rhs.it; }
+      bool operator!=(const deref& rhs) const { return it != rhs.it; }
+    };
+    q.push_range(deref{batch.begin()}, deref{batch.end()});
+    q.push_range(arr.begin() + 1, arr.begin() + 3);
+    REQUIRE(q.pop() == &arr[3]);
+    REQUIRE(q.pop() == &arr[0]);
+    REQUIRE(q.pop() == &arr[5]);
+    REQUIRE(q.pop() == &arr[1]);
+    REQUIRE(q.pop() == &arr[2]);
+    REQUIRE(q.pop() == nullptr);
+  }
+  SUBCASE("reuse after drain") {
+    for (int round = 0; round != 3; ++round) {
+      for (M& m : arr) {
+        q.push(m);
+      }
+      for (M& m : arr) {
+        REQUIRE(q.pop() == &m);
+      }
+      REQUIRE(q.empty());
+    }
+  }
+}
+
+TEST_CASE("mpsc queue multiple producers") {
+  constexpr int producers = 4;
+  constexpr int per_producer = 20000;
+  std::vector<M> items(producers * per_producer);
+  mq q;
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p != producers; ++p) {
+    threads.emplace_back([&, p] {
+      for (int i = 0; i != per_producer; ++i) {
+        M& m = items[p * per_producer + i];
+        m.producer = p;
+        m.seq = i;
+        if (i % 16 == 15) {
+          // every 16th item goes out as part of a batch with the previous one.
+          M& prev = items[p * per_producer + i - 1];
+          prev.producer = p;
+          prev.seq = i - 1;
+          prev.n.set_next(&m.n);
+          q.push_chain(prev, m);
+        } else if (i % 16 != 14) {
+          q.push(m);
+        }
+      }
+    });
+  }
+
+  std::array<int, producers> next_seq{};
+  int received = 0;
+  bool ordered = true;
+  while (received != producers * per_producer) {
+    M* m = q.pop();
+    if (m == nullptr) {
+      std::this_thread::yield();
+      continue;
+    }
+    ordered = ordered && m->seq == next_seq[m->producer];
+    next_seq[m->producer] = m->seq + 1;
+    ++received;
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+  REQUIRE(ordered);
+  REQUIRE(q.pop() == nullptr);
+  REQUIRE(q.empty());
+}
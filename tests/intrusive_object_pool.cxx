@@ -0,0 +1,316 @@
+/*
+ * intrusive_object_pool.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "../intrusive_object_pool.hpp"
+#include "doctest.h"
+#include <atomic>
+#include <list>
+#include <memory_resource>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+struct counted {
+  static inline int alive = 0;
+  int value;
+
+  explicit counted(int v) : value(v) {
+    if (v < 0) {
+      throw std::invalid_argument{"negative"};
+    }
+    ++alive;
+  }
+  ~counted() { --alive; }
+};
+
+// counts what pool_memory_resource passes on.
+class counting_resource : public std::pmr::memory_resource {
+public:
+  int allocations = 0;
+  int deallocations = 0;
+
+private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    ++allocations;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+    ++deallocations;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+// outlives the main thread's caches, which go away before objects with static storage duration.
+pep::intrusive_block_pool static_pool{32, alignof(std::max_align_t), 4};
+
+// uses static_pool from its destructor, after the caches of the thread it lived on are gone.
+struct late_user {
+  bool* done = nullptr;
+
+  ~late_user() {
+    void* a = static_pool.allocate();
+    void* b = static_pool.allocate();
+    static_pool.deallocate(a);
+    static_pool.deallocate(b);
+    if (done != nullptr) {
+      *done = a != nullptr && b != nullptr && a != b;
+    }
+  }
+};
+} // namespace
+
+TEST_CASE("block pool geometry") {
+  pep::intrusive_block_pool tiny{1, 1};
+  REQUIRE(tiny.block_size() >= 4 * sizeof(void*));
+  REQUIRE(tiny.block_size() % tiny.block_align() == 0);
+
+  pep::intrusive_block_pool wide{100, 64, 8};
+  REQUIRE(wide.block_size() == 128);
+  REQUIRE(wide.block_align() == 64);
+  REQUIRE(wide.magazine_size() == 8);
+  for (int i = 0; i != 50; ++i) {
+    REQUIRE(reinterpret_cast<std::uintptr_t>(wide.allocate()) % 64 == 0);
+  }
+}
+
+TEST_CASE("block pool single thread") {
+  pep::intrusive_block_pool pool{48, alignof(std::max_align_t), 4};
+  void* a = pool.allocate();
+  pool.deallocate(a);
+  // the thread's magazine hands back the block freed last.
+  REQUIRE(pool.allocate() == a);
+  pool.deallocate(a);
+
+  // enough blocks to fill both magazines and park several in the depot.
+  std::vector<void*> blocks;
+  for (int i = 0; i != 40; ++i) {
+    blocks.push_back(pool.allocate());
+  }
+  std::set<void*> distinct(blocks.begin(), blocks.end());
+  REQUIRE(distinct.size() == blocks.size());
+  for (void* p : blocks) {
+    pool.deallocate(p);
+  }
+  std::set<void*> again;
+  for (int i = 0; i != 40; ++i) {
+    again.insert(pool.allocate());
+  }
+  // everything came back through the magazines and the depot, nothing new was carved.
+  REQUIRE(again == distinct);
+  for (void* p : again) {
+    pool.deallocate(p);
+  }
+}
+
+TEST_CASE("object pool") {
+  pep::intrusive_object_pool<counted> pool{2};
+  std::vector<counted*> objs;
+  for (int i = 0; i != 10; ++i) {
+    objs.push_back(pool.create(i));
+  }
+  REQUIRE(counted::alive == 10);
+  for (int i = 0; i != 10; ++i) {
+    REQUIRE(objs[i]->value == i);
+  }
+  counted* last = objs.back();
+  pool.destroy(last);
+  objs.pop_back();
+  REQUIRE(counted::alive == 9);
+
+  // a throwing constructor gives its block back.
+  REQUIRE_THROWS_AS((void)pool.create(-1), const std::invalid_argument&);
+  REQUIRE(counted::alive == 9);
+  counted* reused = pool.create(42);
+  REQUIRE(reused == last);
+  objs.push_back(reused);
+  for (counted* c : objs) {
+    pool.destroy(c);
+  }
+  REQUIRE(counted::alive == 0);
+}
+
+TEST_CASE("block pool across threads") {
+  struct slot {
+    std::atomic<int> owner{0};
+  };
+  pep::intrusive_object_pool<slot> pool{8};
+
+  SUBCASE("freed elsewhere") {
+    // blocks allocated on one thread and freed on another come back through the depot.
+    std::vector<slot*> handed;
+    std::thread producer{[&] {
+      for (int i = 0; i != 100; ++i) {
+        handed.push_back(pool.allocate());
+      }
+    }};
+    producer.join();
+    for (slot* s : handed) {
+      pool.deallocate(s);
+    }
+    std::set<slot*> seen(handed.begin(), handed.end());
+    std::vector<slot*> taken;
+    std::thread consumer{[&] {
+      for (int i = 0; i != 100; ++i) {
+        taken.push_back(pool.allocate());
+      }
+      for (slot* s : taken) {
+        pool.deallocate(s);
+      }
+    }};
+    consumer.join();
+    std::size_t recycled = 0;
+    for (slot* s : taken) {
+      recycled += seen.count(s);
+    }
+    // main parks its full magazines, the consumer picks them up; the two partial ones it keeps
+    // are the only blocks it can't see.
+    REQUIRE(recycled >= 100 - 2 * pool.blocks().magazine_size());
+  }
+
+  SUBCASE("churn") {
+    // every thread allocates a batch, stamps each block with its id and hands half of it to the
+    // next thread to free. A block handed out twice at once shows up as a foreign stamp.
+    constexpr int threads = 4;
+    constexpr int rounds = 2000;
+    constexpr int batch = 24;
+    std::atomic<bool> exclusive{true};
+    std::vector<std::vector<slot*>> mailbox(threads);
+    std::vector<std::mutex> locks(threads);
+    std::vector<std::thread> workers;
+    auto release = [&](slot* s, int owner) {
+      if (s->owner.exchange(0) != owner) {
+        exclusive = false;
+      }
+      pool.destroy(s);
+    };
+    for (int t = 0; t != threads; ++t) {
+      workers.emplace_back([&, t] {
+        int self = t + 1;
+        int prev = (t + threads - 1) % threads + 1;
+        std::vector<slot*> mine;
+        for (int r = 0; r != rounds; ++r) {
+          for (int i = 0; i != batch; ++i) {
+            slot* s = pool.create();
+            s->owner.store(self);
+            mine.push_back(s);
+          }
+          std::vector<slot*> incoming;
+          {
+            std::lock_guard<std::mutex> guard{locks[t]};
+            incoming.swap(mailbox[t]);
+          }
+          for (slot* s : incoming) {
+            release(s, prev);
+          }
+          std::size_t half = mine.size() / 2;
+          {
+            std::vector<slot*>& box = mailbox[(t + 1) % threads];
+            std::lock_guard<std::mutex> guard{locks[(t + 1) % threads]};
+            box.insert(box.end(), mine.begin() + half, mine.end());
+          }
+          mine.resize(half);
+          for (slot* s : mine) {
+            release(s, self);
+          }
+          mine.clear();
+        }
+      });
+    }
+    for (std::thread& w : workers) {
+      w.join();
+    }
+    for (int t = 0; t != threads; ++t) {
+      for (slot* s : mailbox[t]) {
+        release(s, (t + threads - 1) % threads + 1);
+      }
+    }
+    REQUIRE(exclusive);
+  }
+}
+
+TEST_CASE("pool_memory_resource") {
+  counting_resource upstream;
+  pep::intrusive_block_pool pool{64, alignof(std::max_align_t), 16};
+  pep::pool_memory_resource resource{pool, &upstream};
+  REQUIRE(resource.upstream_resource() == &upstream);
+  REQUIRE(resource.is_equal(resource));
+
+  {
+    std::pmr::list<int> values{&resource};
+    for (int i = 0; i != 1000; ++i) {
+      values.push_back(i);
+    }
+    REQUIRE(values.size() == 1000);
+    REQUIRE(values.back() == 999);
+  }
+  // list nodes fit a block, nothing went upstream.
+  REQUIRE(upstream.allocations == 0);
+
+  {
+    std::pmr::vector<char> big{&resource};
+    big.resize(4096);
+  }
+  REQUIRE(upstream.allocations == 1);
+  REQUIRE(upstream.deallocations == 1);
+
+  void* p = resource.allocate(64, 128);
+  REQUIRE(upstream.allocations == 2);
+  resource.deallocate(p, 64, 128);
+  REQUIRE(upstream.deallocations == 2);
+}
+
+TEST_CASE("pool outlived by a thread cache") {
+  // a worker's cache keeps the pool's memory alive until the worker exits.
+  std::atomic<int> stage{0};
+  void* block = nullptr;
+  std::thread worker;
+  {
+    pep::intrusive_block_pool pool{32};
+    worker = std::thread{[&] {
+      block = pool.allocate();
+      pool.deallocate(block);
+      stage = 1;
+      while (stage != 2) {
+      }
+    }};
+    while (stage != 1) {
+    }
+  }
+  stage = 2;
+  worker.join();
+  REQUIRE(block != nullptr);
+}
+
+TEST_CASE("pool with static storage duration") {
+  void* p = static_pool.allocate();
+  static_pool.deallocate(p);
+
+  // freed at exit, after the main thread's caches.
+  static pep::pool_memory_resource resource{static_pool};
+  static std::pmr::list<int> leftovers{&resource};
+  for (int i = 0; i != 10; ++i) {
+    leftovers.push_back(i);
+  }
+  static late_user at_exit;
+
+  // constructed before the thread first uses the pool, so destroyed after its caches.
+  bool done = false;
+  std::thread worker{[&] {
+    thread_local late_user user;
+    user.done = &done;
+    for (int i = 0; i != 20; ++i) {
+      static_pool.deallocate(static_pool.allocate());
+    }
+  }};
+  worker.join();
+  REQUIRE(done);
+}
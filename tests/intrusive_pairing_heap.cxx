@@ -0,0 +1,138 @@
+/*
+ * intrusive_pairing_heap.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "../intrusive_pairing_heap.hpp"
+#include "doctest.h"
+#include <random>
+#include <set>
+#include <vector>
+
+namespace {
+struct job {
+  int deadline = 0;
+  pep::intrusive_heap_node n;
+
+  friend bool operator<(const job& a, const job& b) { return a.deadline < b.deadline; }
+};
+
+using heap = pep::intrusive_pairing_heap<job, &job::n>;
+
+std::vector<int> drain(heap& h) {
+  std::vector<int> out;
+  while (!h.empty()) {
+    out.push_back(h.top().deadline);
+    h.pop();
+  }
+  return out;
+}
+} // namespace
+
+TEST_CASE("pairing heap") {
+  std::vector<job> jobs(6);
+  int ds[] = {5, 1, 4, 2, 3, 0};
+  for (int i = 0; i != 6; ++i) {
+    jobs[i].deadline = ds[i];
+  }
+  heap h;
+  REQUIRE(h.empty());
+  for (job& j : jobs) {
+    h.push(j);
+    REQUIRE(j.n.is_linked());
+  }
+  REQUIRE(h.size() == 6);
+  REQUIRE(h.top().deadline == 0);
+
+  SUBCASE("pop") {
+    REQUIRE(drain(h) == std::vector<int>{0, 1, 2, 3, 4, 5});
+  }
+  SUBCASE("decrease") {
+    jobs[0].deadline = -1;
+    h.decrease(jobs[0]);
+    REQUIRE(&h.top() == &jobs[0]);
+    jobs[2].deadline = 1;
+    h.decrease(jobs[2]);
+    REQUIRE(drain(h) == std::vector<int>{-1, 0, 1, 1, 2, 3});
+  }
+  SUBCASE("erase") {
+    h.erase(jobs[5]);
+    REQUIRE(!jobs[5].n.is_linked());
+    h.erase(jobs[2]);
+    REQUIRE(h.size() == 4);
+    REQUIRE(drain(h) == std::vector<int>{1, 2, 3, 5});
+  }
+  SUBCASE("merge") {
+    std::vector<job> more(3);
+    heap other;
+    for (int i = 0; i != 3; ++i) {
+      more[i].deadline = 10 - 5 * i;
+      other.push(more[i]);
+    }
+    h.merge(other);
+    REQUIRE(other.empty());
+    REQUIRE(h.size() == 9);
+    REQUIRE(drain(h) == std::vector<int>{0, 0, 1, 2, 3, 4, 5, 5, 10});
+  }
+  SUBCASE("move") {
+    heap other{std::move(h)};
+    REQUIRE(h.empty());
+    REQUIRE(other.size() == 6);
+    h = std::move(other);
+    REQUIRE(other.empty());
+    REQUIRE(h.top().deadline == 0);
+  }
+  h.clear();
+  REQUIRE(h.empty());
+  for (job& j : jobs) {
+    REQUIRE(!j.n.is_linked());
+  }
+}
+
+TEST_CASE("pairing heap against std::multiset") {
+  constexpr int n = 2000;
+  std::vector<job> jobs(n);
+  std::mt19937 rng{3};
+  heap h;
+  std::multiset<int> model;
+  bool matches = true;
+  for (int step = 0; step != 40000; ++step) {
+    job& j = jobs[rng() % n];
+    switch (rng() % 4) {
+    case 0:
+      if (!j.n.is_linked()) {
+        j.deadline = static_cast<int>(rng() % 100000);
+        h.push(j);
+        model.insert(j.deadline);
+      }
+      break;
+    case 1:
+      if (j.n.is_linked()) {
+        model.erase(model.find(j.deadline));
+        j.deadline -= static_cast<int>(rng() % 1000);
+        h.decrease(j);
+        model.insert(j.deadline);
+      }
+      break;
+    case 2:
+      if (j.n.is_linked()) {
+        h.erase(j);
+        model.erase(model.find(j.deadline));
+      }
+      break;
+    default:
+      if (!h.empty()) {
+        matches = matches && h.top().deadline == *model.begin();
+        model.erase(model.begin());
+        h.pop();
+      }
+      break;
+    }
+    matches = matches && h.size() == model.size();
+  }
+  REQUIRE(matches);
+  std::vector<int> rest = drain(h);
+  REQUIRE(rest == std::vector<int>(model.begin(), model.end()));
+}
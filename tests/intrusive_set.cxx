@@ -0,0 +1,170 @@
+/*
+ * intrusive_set.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "../intrusive_set.hpp"
+#include "doctest.h"
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace {
+struct R {
+  int key;
+  pep::intrusive_rbtree_node n;
+
+  friend bool operator<(const R& a, const R& b) { return a.key < b.key; }
+};
+
+struct by_key {
+  bool operator()(const R& a, const R& b) const { return a.key < b.key; }
+  bool operator()(const R& a, int b) const { return a.key < b; }
+  bool operator()(int a, const R& b) const { return a < b.key; }
+};
+
+struct checked_set : pep::intrusive_set<R, &R::n, by_key> {
+  using pep::intrusive_set<R, &R::n, by_key>::tree_invariant;
+};
+
+std::vector<int> keys(const checked_set& s) {
+  std::vector<int> out;
+  for (const R& r : s) {
+    out.push_back(r.key);
+  }
+  return out;
+}
+} // namespace
+
+TEST_CASE("rbtree node") {
+  static_assert(sizeof(pep::intrusive_rbtree_node) == 3 * sizeof(void*));
+  pep::intrusive_rbtree_node n;
+  REQUIRE(!n.is_linked());
+}
+
+TEST_CASE("set") {
+  std::vector<R> items(6);
+  int ks[] = {5, 1, 4, 2, 3, 0};
+  for (int i = 0; i != 6; ++i) {
+    items[i].key = ks[i];
+  }
+  checked_set s;
+  REQUIRE(s.empty());
+  REQUIRE(s.begin() == s.end());
+  REQUIRE(s.find(1) == s.end());
+  for (R& r : items) {
+    auto inserted = s.insert(r);
+    REQUIRE(inserted.second);
+    REQUIRE(&*inserted.first == &r);
+    REQUIRE(r.n.is_linked());
+    s.tree_invariant();
+  }
+  REQUIRE(s.size() == 6);
+  REQUIRE(keys(s) == std::vector<int>{0, 1, 2, 3, 4, 5});
+  REQUIRE(s.front().key == 0);
+  REQUIRE(s.back().key == 5);
+
+  R dup;
+  dup.key = 3;
+  auto existing = s.insert(dup);
+  REQUIRE(!existing.second);
+  REQUIRE(existing.first->key == 3);
+  REQUIRE(&*existing.first != &dup);
+  REQUIRE(!dup.n.is_linked());
+
+  REQUIRE(s.find(4)->key == 4);
+  REQUIRE(s.find(9) == s.end());
+  REQUIRE(s.lower_bound(-1)->key == 0);
+  REQUIRE(s.lower_bound(3)->key == 3);
+  REQUIRE(s.upper_bound(3)->key == 4);
+  REQUIRE(s.lower_bound(6) == s.end());
+  REQUIRE(s.upper_bound(5) == s.end());
+
+  std::vector<int> backwards;
+  for (auto it = s.end(); it != s.begin();) {
+    --it;
+    backwards.push_back(it->key);
+  }
+  REQUIRE(backwards == std::vector<int>{5, 4, 3, 2, 1, 0});
+
+  SUBCASE("erase") {
+    s.erase(items[2]);
+    REQUIRE(!items[2].n.is_linked());
+    auto it = s.erase(s.find(1));
+    REQUIRE(it->key == 2);
+    s.tree_invariant();
+    REQUIRE(keys(s) == std::vector<int>{0, 2, 3, 5});
+    REQUIRE(s.insert(items[2]).second);
+    REQUIRE(keys(s) == std::vector<int>{0, 2, 3, 4, 5});
+  }
+  SUBCASE("auto unlink") {
+    {
+      R temp;
+      temp.key = 10;
+      s.insert(temp);
+      REQUIRE(s.back().key == 10);
+    }
+    s.tree_invariant();
+    REQUIRE(s.back().key == 5);
+    items[0].n.unlink();
+    REQUIRE(keys(s) == std::vector<int>{0, 1, 2, 3, 4});
+  }
+  SUBCASE("node move") {
+    R moved;
+    moved.key = items[4].key;
+    moved.n = std::move(items[4].n);
+    REQUIRE(!items[4].n.is_linked());
+    REQUIRE(moved.n.is_linked());
+    REQUIRE(&*s.find(3) == &moved);
+    s.tree_invariant();
+    s.erase(moved);
+  }
+  SUBCASE("set move") {
+    checked_set other{std::move(s)};
+    REQUIRE(s.empty());
+    REQUIRE(keys(other) == std::vector<int>{0, 1, 2, 3, 4, 5});
+    other.tree_invariant();
+    s = std::move(other);
+    REQUIRE(other.empty());
+    REQUIRE(keys(s) == std::vector<int>{0, 1, 2, 3, 4, 5});
+  }
+  s.clear();
+  REQUIRE(s.empty());
+  for (R& r : items) {
+    REQUIRE(!r.n.is_linked());
+  }
+}
+
+TEST_CASE("set against std::set") {
+  constexpr int n = 2000;
+  std::unique_ptr<R[]> items{new R[n]};
+  for (int i = 0; i != n; ++i) {
+    items[i].key = i;
+  }
+  std::mt19937 rng{1};
+  checked_set s;
+  std::set<int> model;
+  bool matches = true;
+  for (int step = 0; step != 20000; ++step) {
+    int i = static_cast<int>(rng() % n);
+    if (rng() % 2 == 0) {
+      bool inserted = s.insert(items[i]).second;
+      matches = matches && inserted == model.insert(i).second;
+    } else if (items[i].n.is_linked()) {
+      s.erase(items[i]);
+      model.erase(i);
+    }
+    if (step % 1000 == 0) {
+      s.tree_invariant();
+      matches = matches && std::equal(s.begin(), s.end(), model.begin(), model.end(),
+                                      [](const R& r, int k) { return r.key == k; });
+    }
+  }
+  s.tree_invariant();
+  REQUIRE(matches);
+  REQUIRE(s.size() == model.size());
+}
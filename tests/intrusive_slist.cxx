@@ -0,0 +1,150 @@
+/*
+ * intrusive_slist.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "../intrusive_slist.hpp"
+#include "doctest.h"
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+namespace {
+struct F {
+  int i;
+  pep::intrusive_slist_node n;
+};
+
+using fl = pep::intrusive_slist<F, &F::n>;
+using cfl = pep::intrusive_slist<F, &F::n, pep::cache_last<true>>;
+
+template <typename L>
+int sum(const L& l) {
+  return std::accumulate(l.begin(), l.end(), 0, [](int a, const F& b) { return a + b.i; });
+}
+} // namespace
+
+TEST_CASE("slist types") {
+  static_assert(sizeof(pep::intrusive_slist_node) == sizeof(void*));
+  static_assert(sizeof(fl) == sizeof(void*));
+  static_assert(sizeof(cfl) == 2 * sizeof(void*));
+  static_assert((std::is_same<fl::value_type, F>::value));
+  static_assert((std::is_same<std::iterator_traits<fl::iterator>::iterator_category,
+                              std::forward_iterator_tag>::value));
+}
+
+TEST_CASE("slist") {
+  std::array<F, 4> arr{{{1, {}}, {2, {}}, {3, {}}, {4, {}}}};
+  fl l;
+  REQUIRE(l.empty());
+  REQUIRE(l.begin() == l.end());
+  REQUIRE(l.size() == 0);
+
+  SUBCASE("stack") {
+    for (F& f : arr) {
+      l.push_front(f);
+    }
+    REQUIRE(l.size() == 4);
+    REQUIRE(&l.front() == &arr[3]);
+    REQUIRE(std::equal(l.begin(), l.end(), arr.rbegin(),
+                       [](const F& a, const F& b) { return &a == &b; }));
+    l.pop_front();
+    REQUIRE(!arr[3].n.is_linked());
+    REQUIRE(&l.front() == &arr[2]);
+    REQUIRE(sum(l) == 6);
+    l.clear();
+    REQUIRE(l.empty());
+    REQUIRE(!arr[0].n.is_linked());
+  }
+  SUBCASE("insert/erase after") {
+    l.push_front(arr[0]);
+    l.insert_after(&arr[0], arr[2]);
+    l.insert_after(l.begin(), arr[1]);
+    l.insert_after(l.before_begin(), arr[3]);
+    REQUIRE(l.size() == 4);
+    auto it = l.begin();
+    REQUIRE(&*it++ == &arr[3]);
+    REQUIRE(&*it++ == &arr[0]);
+    REQUIRE(&*it++ == &arr[1]);
+    REQUIRE(&*it++ == &arr[2]);
+    REQUIRE(it == l.end());
+
+    l.erase_after(&arr[0]);
+    REQUIRE(!arr[1].n.is_linked());
+    l.erase_after(l.before_begin());
+    REQUIRE(!arr[3].n.is_linked());
+    REQUIRE(sum(l) == 4);
+    l.erase_after(l.begin());
+    REQUIRE(l.size() == 1);
+    l.pop_front();
+    REQUIRE(l.empty());
+  }
+  SUBCASE("move") {
+    for (F& f : arr) {
+      l.push_front(f);
+    }
+    fl l2 = std::move(l);
+    REQUIRE(l.empty());
+    REQUIRE(l2.size() == 4);
+    REQUIRE(sum(l2) == 10);
+    l = std::move(l2);
+    REQUIRE(l2.empty());
+    REQUIRE(l.size() == 4);
+    l.clear();
+  }
+  SUBCASE("destructor unlinks") {
+    {
+      fl l2;
+      l2.push_front(arr[0]);
+      l2.push_front(arr[1]);
+    }
+    REQUIRE(!arr[0].n.is_linked());
+    REQUIRE(!arr[1].n.is_linked());
+  }
+}
+
+TEST_CASE("slist cache_last") {
+  std::array<F, 4> arr{{{1, {}}, {2, {}}, {3, {}}, {4, {}}}};
+  cfl l;
+  for (F& f : arr) {
+    l.push_back(f);
+  }
+  REQUIRE(&l.front() == &arr[0]);
+  REQUIRE(&l.back() == &arr[3]);
+  REQUIRE(std::equal(l.begin(), l.end(), arr.begin(),
+                     [](const F& a, const F& b) { return &a == &b; }));
+
+  // erasing the last element moves the cached tail back.
+  l.erase_after(&arr[2]);
+  REQUIRE(&l.back() == &arr[2]);
+  l.insert_after(&arr[2], arr[3]);
+  REQUIRE(&l.back() == &arr[3]);
+
+  // FIFO usage.
+  l.pop_front();
+  l.push_back(arr[0]);
+  REQUIRE(&l.front() == &arr[1]);
+  REQUIRE(&l.back() == &arr[0]);
+
+  cfl l2 = std::move(l);
+  REQUIRE(l.empty());
+  REQUIRE(&l2.back() == &arr[0]);
+  l2.pop_front();
+  l.push_back(arr[1]);
+  REQUIRE(&l.front() == &arr[1]);
+  REQUIRE(&l.back() == &arr[1]);
+
+  while (!l2.empty()) {
+    l2.pop_front();
+  }
+  l2.push_back(arr[2]);
+  REQUIRE(&l2.front() == &arr[2]);
+  REQUIRE(&l2.back() == &arr[2]);
+  l = std::move(l2);
+  REQUIRE(!arr[1].n.is_linked());
+  REQUIRE(&l.back() == &arr[2]);
+  l.push_back(arr[1]);
+  REQUIRE(sum(l) == 5);
+}
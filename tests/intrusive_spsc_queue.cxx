@@ -0,0 +1,163 @@
+/*
+ * intrusive_spsc_queue.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "../intrusive_spsc_queue.hpp"
+#include "doctest.h"
+#include <algorithm>
+#include <array>
+#include <thread>
+#include <vector>
+
+namespace {
+struct Q {
+  int seq;
+  pep::intrusive_spsc_node n;
+};
+
+using sq = pep::intrusive_spsc_queue<Q, &Q::n>;
+} // namespace
+
+TEST_CASE("spsc queue single thread") {
+  std::array<Q, 6> arr{};
+  for (int i = 0; i != 6; ++i) {
+    arr[i].seq = i;
+  }
+  // the queue keeps the hook of the element popped last, so this warm-up uses elements of its own.
+  std::array<Q, 2> warm{};
+  sq q;
+  REQUIRE(q.empty());
+  REQUIRE(q.pop() == nullptr);
+
+  q.push(warm[0]);
+  REQUIRE(!q.empty());
+  q.push(warm[1]);
+  REQUIRE(q.pop() == &warm[0]);
+  REQUIRE(q.pop() == &warm[1]);
+  REQUIRE(q.pop() == nullptr);
+  REQUIRE(q.empty());
+
+  SUBCASE("push_chain") {
+    arr[2].n.set_next(&arr[3].n);
+    arr[3].n.set_next(&arr[4].n);
+    q.push(arr[1]);
+    q.push_chain(arr[2], arr[4]);
+    q.push(arr[5]);
+    for (int i = 1; i != 6; ++i) {
+      REQUIRE(q.pop() == &arr[i]);
+    }
+    REQUIRE(q.pop() == nullptr);
+  }
+  SUBCASE("push_range and pop_bulk") {
+    q.push_range(arr.begin(), arr.end());
+    std::array<Q*, 4> out{};
+    REQUIRE(q.pop_bulk(out.begin(), out.size()) == 4);
+    for (int i = 0; i != 4; ++i) {
+      REQUIRE(out[i] == &arr[i]);
+    }
+    REQUIRE(q.pop_bulk(out.begin(), out.size()) == 2);
+    REQUIRE(out[0] == &arr[4]);
+    REQUIRE(out[1] == &arr[5]);
+    REQUIRE(q.pop_bulk(out.begin(), out.size()) == 0);
+  }
+  SUBCASE("popped elements are released by the next pop") {
+    for (int round = 0; round != 3; ++round) {
+      q.push(arr[round % 2]);
+      REQUIRE(q.pop() == &arr[round % 2]);
+      REQUIRE(q.empty());
+    }
+    // arr[0] was released by popping arr[1] and can go round again.
+    q.push(arr[2]);
+    q.push(arr[1]);
+    REQUIRE(q.pop() == &arr[2]);
+    REQUIRE(q.pop() == &arr[1]);
+    q.push(arr[2]);
+    std::array<Q*, 4> out{};
+    REQUIRE(q.pop_bulk(out.begin(), out.size()) == 1);
+    REQUIRE(out[0] == &arr[2]);
+    REQUIRE(q.pop() == nullptr);
+  }
+}
+
+TEST_CASE("spsc queue producer and consumer threads") {
+  // elements cycle between the two threads through a second queue, so the producer keeps
+  // re-pushing hooks the consumer has just released.
+  constexpr int total = 200000;
+  std::vector<Q> items(64);
+  sq forward;
+  sq back;
+  for (Q& q : items) {
+    back.push(q);
+  }
+
+  struct deref {
+    Q** it;
+    Q& operator*() const { return **it; }
+    deref& operator++() {
+      ++it;
+      return *this;
+    }
+    bool operator==(const deref& rhs) const { return it == rhs.it; }
+    bool operator!=(const deref& rhs) const { return it != rhs.it; }
+  };
+
+  // each thread holds on to the element it popped last until its next pop releases it.
+  std::thread producer([&] {
+    int seq = 0;
+    Q* held = nullptr;
+    std::vector<Q*> ready;
+    for (int round = 0; seq != total; ++round) {
+      std::array<Q*, 4> got{};
+      std::size_t count = 0;
+      if (round % 2 == 0) {
+        got[0] = back.pop();
+        count = got[0] != nullptr;
+      } else {
+        count = back.pop_bulk(got.begin(), got.size());
+      }
+      if (count == 0) {
+        std::this_thread::yield();
+        continue;
+      }
+      ready.clear();
+      if (held != nullptr) {
+        ready.push_back(held);
+      }
+      ready.insert(ready.end(), got.begin(), got.begin() + count - 1);
+      held = got[count - 1];
+      ready.resize(std::min<std::size_t>(ready.size(), total - seq));
+      for (Q* q : ready) {
+        q->seq = seq++;
+      }
+      if (ready.size() == 1) {
+        forward.push(*ready[0]);
+      } else if (!ready.empty()) {
+        forward.push_range(deref{ready.data()}, deref{ready.data() + ready.size()});
+      }
+    }
+  });
+
+  int expected = 0;
+  bool ordered = true;
+  Q* held = nullptr;
+  while (expected < total) {
+    Q* q = forward.pop();
+    if (q == nullptr) {
+      std::this_thread::yield();
+      continue;
+    }
+    ordered = ordered && q->seq == expected;
+    expected = q->seq + 1;
+    if (held != nullptr) {
+      back.push(*held);
+    }
+    held = q;
+  }
+  producer.join();
+  REQUIRE(ordered);
+  REQUIRE(expected == total);
+  REQUIRE(forward.pop() == nullptr);
+}
@@ -0,0 +1,143 @@
+/*
+ * intrusive_timer_wheel.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "../intrusive_timer_wheel.hpp"
+#include "doctest.h"
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+struct timer {
+  int id = 0;
+  std::uint64_t expiry = 0;
+  pep::intrusive_node n;
+};
+
+using wheel = pep::intrusive_timer_wheel<timer, &timer::n, &timer::expiry>;
+
+// (tick, id) of every expiry while advancing to `now`.
+std::vector<std::pair<std::uint64_t, int>> fire(wheel& w, std::uint64_t now) {
+  std::vector<std::pair<std::uint64_t, int>> out;
+  w.advance(now, [&](timer& t) {
+    REQUIRE(!wheel::is_scheduled(t));
+    out.emplace_back(w.now(), t.id);
+  });
+  return out;
+}
+} // namespace
+
+TEST_CASE("timer wheel") {
+  std::vector<timer> ts(5);
+  for (int i = 0; i != 5; ++i) {
+    ts[i].id = i;
+  }
+  wheel w;
+  REQUIRE(w.now() == 0);
+  w.schedule(ts[0], 3);
+  w.schedule(ts[1], 64);
+  w.schedule(ts[2], 5000);
+  w.schedule(ts[3], 300000);
+  w.schedule(ts[4], 3);
+  REQUIRE(wheel::is_scheduled(ts[2]));
+
+  using fired = std::vector<std::pair<std::uint64_t, int>>;
+  REQUIRE(fire(w, 2).empty());
+  REQUIRE(fire(w, 3) == fired{{3, 0}, {3, 4}});
+  REQUIRE(fire(w, 4000) == fired{{64, 1}});
+
+  SUBCASE("cancel") {
+    REQUIRE(w.cancel(ts[2]));
+    REQUIRE(!w.cancel(ts[2]));
+    REQUIRE(!wheel::is_scheduled(ts[2]));
+    REQUIRE(fire(w, 1000000) == fired{{300000, 3}});
+  }
+  SUBCASE("reschedule") {
+    w.reschedule(ts[2], 4001);
+    w.reschedule(ts[3], 4500);
+    REQUIRE(fire(w, 1000000) == fired{{4001, 2}, {4500, 3}});
+  }
+  SUBCASE("destroying a timer cancels it") {
+    {
+      timer temp;
+      w.schedule(temp, 4100);
+    }
+    REQUIRE(fire(w, 1000000) == fired{{5000, 2}, {300000, 3}});
+  }
+  SUBCASE("past expiry fires on the next tick") {
+    w.schedule(ts[0], 10);
+    REQUIRE(fire(w, 4001) == fired{{4001, 0}});
+  }
+  SUBCASE("rescheduling from the callback") {
+    int fired_count = 0;
+    w.advance(20000, [&](timer& t) {
+      ++fired_count;
+      if (t.id == 2) {
+        w.schedule(t, w.now() + 1);
+      } else if (t.id == 1) {
+        FAIL("already fired");
+      }
+    });
+    REQUIRE(fired_count == 15001);
+    REQUIRE(wheel::is_scheduled(ts[2]));
+  }
+  w.clear();
+  for (timer& t : ts) {
+    REQUIRE(!wheel::is_scheduled(t));
+  }
+}
+
+TEST_CASE("timer wheel far expiry") {
+  timer near, far;
+  wheel w{(std::uint64_t{1} << 36) - 5};
+  w.schedule(near, w.now() + 10);
+  w.schedule(far, w.now() + (std::uint64_t{1} << 37));
+  REQUIRE(fire(w, w.now() + 10).size() == 1);
+  REQUIRE(!wheel::is_scheduled(near));
+  // jumping straight to the far timer's tick walks 2^37 ticks, so bring the wheel close first.
+  wheel w2{far.expiry - 70};
+  w.cancel(far);
+  w2.schedule(far, far.expiry);
+  REQUIRE(fire(w2, far.expiry) == std::vector<std::pair<std::uint64_t, int>>{{far.expiry, 0}});
+}
+
+TEST_CASE("timer wheel against ordered expiries") {
+  constexpr int n = 3000;
+  std::vector<timer> ts(n);
+  std::mt19937_64 rng{7};
+  wheel w{12345};
+  std::multimap<std::uint64_t, int> model;
+  for (int i = 0; i != n; ++i) {
+    ts[i].id = i;
+    // spread over several levels.
+    std::uint64_t delta = 1 + rng() % (std::uint64_t{1} << (rng() % 20));
+    w.schedule(ts[i], w.now() + delta);
+    model.emplace(ts[i].expiry, i);
+  }
+  for (int i = 0; i < n; i += 7) {
+    w.cancel(ts[i]);
+    for (auto it = model.begin(); it != model.end(); ++it) {
+      if (it->second == i) {
+        model.erase(it);
+        break;
+      }
+    }
+  }
+  std::uint64_t last = 0;
+  bool ordered = true;
+  bool on_time = true;
+  std::size_t count = w.advance(12345 + (std::uint64_t{1} << 20), [&](timer& t) {
+    ordered = ordered && w.now() >= last;
+    on_time = on_time && w.now() == t.expiry;
+    last = w.now();
+    model.erase(model.find(t.expiry));
+  });
+  REQUIRE(ordered);
+  REQUIRE(on_time);
+  REQUIRE(model.empty());
+  REQUIRE(count == static_cast<std::size_t>(n - (n + 6) / 7));
+}
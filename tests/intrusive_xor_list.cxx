@@ -0,0 +1,119 @@
+/*
+ * intrusive_xor_list.cxx
+ * Copyright© 2017 rsw0x
+ *
+ * Distributed under terms of the MIT license.
+ */
+
+#include "../intrusive_xor_list.hpp"
+#include "doctest.h"
+#include <array>
+#include <vector>
+
+namespace {
+struct X {
+  int i;
+  pep::intrusive_xor_node n;
+};
+
+using xl = pep::intrusive_xor_list<X, &X::n>;
+
+std::vector<int> forward(const xl& l) {
+  std::vector<int> out;
+  for (const X& x : l) {
+    out.push_back(x.i);
+  }
+  return out;
+}
+
+std::vector<int> backward(const xl& l) {
+  std::vector<int> out;
+  for (auto it = l.end(); it != l.begin();) {
+    --it;
+    out.push_back(it->i);
+  }
+  return out;
+}
+} // namespace
+
+TEST_CASE("xor list types") {
+  static_assert(sizeof(pep::intrusive_xor_node) == sizeof(void*));
+  static_assert(sizeof(X) < sizeof(int) + sizeof(pep::intrusive_node));
+  static_assert((std::is_same<std::iterator_traits<xl::iterator>::iterator_category,
+                              std::bidirectional_iterator_tag>::value));
+}
+
+TEST_CASE("xor list") {
+  std::array<X, 5> arr{{{0, {}}, {1, {}}, {2, {}}, {3, {}}, {4, {}}}};
+  xl l;
+  REQUIRE(l.empty());
+  REQUIRE(l.begin() == l.end());
+
+  l.push_back(arr[2]);
+  l.push_front(arr[1]);
+  l.push_back(arr[4]);
+  l.push_front(arr[0]);
+  REQUIRE(l.size() == 4);
+  REQUIRE(&l.front() == &arr[0]);
+  REQUIRE(&l.back() == &arr[4]);
+  REQUIRE(forward(l) == std::vector<int>{0, 1, 2, 4});
+  REQUIRE(backward(l) == std::vector<int>{4, 2, 1, 0});
+
+  SUBCASE("insert") {
+    auto it = l.begin();
+    ++it;
+    ++it;
+    ++it;
+    REQUIRE(it->i == 4);
+    auto ins = l.insert(it, arr[3]);
+    REQUIRE(ins->i == 3);
+    REQUIRE(forward(l) == std::vector<int>{0, 1, 2, 3, 4});
+    REQUIRE(backward(l) == std::vector<int>{4, 3, 2, 1, 0});
+    // inserting at end() appends.
+    l.pop_back();
+    l.insert(l.end(), arr[4]);
+    REQUIRE(forward(l) == std::vector<int>{0, 1, 2, 3, 4});
+    // and at begin() prepends.
+    l.pop_front();
+    l.insert(l.begin(), arr[0]);
+    REQUIRE(forward(l) == std::vector<int>{0, 1, 2, 3, 4});
+  }
+  SUBCASE("erase") {
+    auto it = l.begin();
+    ++it;
+    it = l.erase(it);
+    REQUIRE(it->i == 2);
+    REQUIRE(forward(l) == std::vector<int>{0, 2, 4});
+    it = l.erase(it);
+    it = l.erase(it);
+    REQUIRE(it == l.end());
+    REQUIRE(backward(l) == std::vector<int>{0});
+    l.erase(l.begin());
+    REQUIRE(l.empty());
+  }
+  SUBCASE("pop") {
+    l.pop_front();
+    l.pop_back();
+    REQUIRE(forward(l) == std::vector<int>{1, 2});
+    l.pop_back();
+    l.pop_back();
+    REQUIRE(l.empty());
+    l.push_back(arr[3]);
+    REQUIRE(&l.front() == &l.back());
+  }
+  SUBCASE("move") {
+    xl l2 = std::move(l);
+    REQUIRE(l.empty());
+    REQUIRE(forward(l2) == std::vector<int>{0, 1, 2, 4});
+    l = std::move(l2);
+    REQUIRE(l2.empty());
+    REQUIRE(backward(l) == std::vector<int>{4, 2, 1, 0});
+  }
+  SUBCASE("clear") {
+    l.clear();
+    REQUIRE(l.empty());
+    l.push_back(arr[0]);
+    l.push_back(arr[1]);
+    REQUIRE(forward(l) == std::vector<int>{0, 1});
+  }
+}